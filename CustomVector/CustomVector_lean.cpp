@@ -2,6 +2,23 @@
 #include <Windows.h>
 #include <iostream>
 #include <cassert>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
 
 /**
 * Custom vector implementation using virtual memory
@@ -45,6 +62,69 @@ namespace VirtualMemory
 		GetSystemInfo(&sys_inf);
 		return sys_inf.dwPageSize;
 	}
+
+	//Views of file mappings can only be placed at multiples of the allocation granularity (64KB), not the page size
+	size_t GetAllocationGranularity(void)
+	{
+		SYSTEM_INFO sys_inf;
+		GetSystemInfo(&sys_inf);
+		return sys_inf.dwAllocationGranularity;
+	}
+
+	/**
+	 * Maps the same size bytes of physical memory twice, directly behind each other. Writing to base[i] also writes
+	 * base[i + size], so any span of up to size bytes starting inside the first view is contiguous in memory.
+	 * size has to be a multiple of the allocation granularity. Windows has no call to place two views atomically,
+	 * so we look for a free range by reserving it, release it again and map both views into it. If another thread
+	 * grabbed part of the range in between, we just try again
+	 */
+	void* MapMirroredMemory(size_t size, HANDLE& mappingHandle)
+	{
+		const uint64_t mappingSize = static_cast<uint64_t>(size);
+		mappingHandle = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize & 0xFFFFFFFFu), nullptr);
+		if (mappingHandle == nullptr)
+		{
+			return nullptr;
+		}
+
+		for (int attempt = 0; attempt < 16; ++attempt)
+		{
+			void* range = ReserveAddressSpace(size * 2u);
+			if (range == nullptr)
+			{
+				break;
+			}
+			FreeAddressSpace(range);
+
+			void* const secondAddress = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(range) + size);
+			void* first = MapViewOfFileEx(mappingHandle, FILE_MAP_ALL_ACCESS, 0u, 0u, size, range);
+			void* second = first ? MapViewOfFileEx(mappingHandle, FILE_MAP_ALL_ACCESS, 0u, 0u, size, secondAddress) : nullptr;
+			if (first == range && second == secondAddress)
+			{
+				return range;
+			}
+
+			if (first != nullptr)
+			{
+				UnmapViewOfFile(first);
+			}
+			if (second != nullptr)
+			{
+				UnmapViewOfFile(second);
+			}
+		}
+
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+		return nullptr;
+	}
+
+	void FreeMirroredMemory(void* base, size_t size, HANDLE mappingHandle)
+	{
+		UnmapViewOfFile(base);
+		UnmapViewOfFile(reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(base) + size));
+		CloseHandle(mappingHandle);
+	}
 }
 
 /**
@@ -77,6 +157,613 @@ namespace MathUtil
 	}
 }
 
+/**
+ * DeferredReclaimer runs the expensive part of destroying a large vector on a background thread: calling the DTORs
+ * of all elements and handing the address space back to the OS. A vector with deferred destruction enabled just
+ * enqueues its reservation on destruction and returns immediately.
+ * The queue is bounded in jobs and in committed bytes. If it is full, the destroying thread waits until the reclaimer
+ * catches up (backpressure), so a burst of destructions can never pile up more memory than the limit.
+ * Vectors with static storage duration must not use deferred destruction, the reclaimer may already be gone when they die
+ */
+class DeferredReclaimer
+{
+public:
+	typedef void (*DestroyFunction)(void* elements, size_t count);
+
+	static DeferredReclaimer& Instance(void);
+
+	void Enqueue(DestroyFunction destroyElements, void* elements, size_t count, void* reservation, size_t committedBytes);
+	void Drain(void);
+
+	~DeferredReclaimer(void);
+
+private:
+	DeferredReclaimer(void);
+	DeferredReclaimer(const DeferredReclaimer& other) = delete;
+	DeferredReclaimer& operator=(const DeferredReclaimer& other) = delete;
+
+	void Run(void);
+
+	struct Job
+	{
+		DestroyFunction destroyElements;
+		void* elements;
+		size_t count;
+		void* reservation;
+		size_t committedBytes;
+	};
+
+	static const size_t MAX_PENDING_JOBS = 64;
+	static const size_t MAX_PENDING_BYTES = 1024 * 1024 * 1024;
+
+	Job m_jobs[MAX_PENDING_JOBS];
+	size_t m_firstJob;
+	size_t m_jobCount;
+	size_t m_pendingBytes;
+	bool m_isWorking;
+	bool m_shutdown;
+
+	std::mutex m_mutex;
+	std::condition_variable m_jobAvailable;
+	std::condition_variable m_jobDone;
+	std::thread m_worker;
+};
+
+DeferredReclaimer& DeferredReclaimer::Instance()
+{
+	static DeferredReclaimer instance;
+	return instance;
+}
+
+DeferredReclaimer::DeferredReclaimer()
+	: m_firstJob(0u)
+	, m_jobCount(0u)
+	, m_pendingBytes(0u)
+	, m_isWorking(false)
+	, m_shutdown(false)
+{
+	m_worker = std::thread(&DeferredReclaimer::Run, this);
+}
+
+/**
+ * Everything still in the queue is reclaimed before the process goes on with its shutdown
+ */
+DeferredReclaimer::~DeferredReclaimer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_shutdown = true;
+	}
+	m_jobAvailable.notify_one();
+	m_worker.join();
+}
+
+/**
+ * Blocks while the queue is full. A single job larger than MAX_PENDING_BYTES is still accepted once the queue is empty
+ */
+void DeferredReclaimer::Enqueue(DestroyFunction destroyElements, void* elements, size_t count, void* reservation, size_t committedBytes)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_jobDone.wait(lock, [this, committedBytes]()
+		{
+			const bool hasFreeSlot = m_jobCount < MAX_PENDING_JOBS;
+			const bool fitsByteLimit = m_pendingBytes == 0u || m_pendingBytes + committedBytes <= MAX_PENDING_BYTES;
+			return hasFreeSlot && fitsByteLimit;
+		});
+
+		Job& job = m_jobs[(m_firstJob + m_jobCount) % MAX_PENDING_JOBS];
+		job.destroyElements = destroyElements;
+		job.elements = elements;
+		job.count = count;
+		job.reservation = reservation;
+		job.committedBytes = committedBytes;
+
+		++m_jobCount;
+		m_pendingBytes += committedBytes;
+	}
+	m_jobAvailable.notify_one();
+}
+
+/**
+ * Waits until every job enqueued so far has been reclaimed
+ */
+void DeferredReclaimer::Drain()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_jobDone.wait(lock, [this]() { return m_jobCount == 0u && !m_isWorking; });
+}
+
+void DeferredReclaimer::Run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_jobAvailable.wait(lock, [this]() { return m_jobCount != 0u || m_shutdown; });
+		if (m_jobCount == 0u)
+		{
+			return;
+		}
+
+		// The job stays accounted for until its memory is really gone, otherwise the byte limit would not hold
+		const Job job = m_jobs[m_firstJob];
+		m_firstJob = (m_firstJob + 1u) % MAX_PENDING_JOBS;
+		--m_jobCount;
+		m_isWorking = true;
+
+		lock.unlock();
+		job.destroyElements(job.elements, job.count);
+		VirtualMemory::FreeAddressSpace(job.reservation);
+		lock.lock();
+
+		m_isWorking = false;
+		m_pendingBytes -= job.committedBytes;
+		m_jobDone.notify_all();
+	}
+}
+
+/**
+ * CompilerHints namespace wraps compiler specific annotations that help the optimizer
+ */
+namespace CompilerHints
+{
+	/**
+	 * Tells the compiler that pointer is aligned to Alignment bytes (a power of two), so it can use aligned
+	 * vector loads / stores and skip the peeling loops it would generate for unaligned data
+	 */
+	template <size_t Alignment, typename T>
+	T* AssumeAligned(T* pointer)
+	{
+#if defined(_MSC_VER)
+		__assume((reinterpret_cast<uintptr_t>(pointer) & (Alignment - 1u)) == 0u);
+		return pointer;
+#else
+		return static_cast<T*>(__builtin_assume_aligned(pointer, Alignment));
+#endif
+	}
+
+	/**
+	 * Asks the CPU to load the cache line of address into all cache levels, without waiting for it and without
+	 * faulting on invalid addresses
+	 */
+	template <typename T>
+	void Prefetch(const T* address)
+	{
+		_mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0);
+	}
+}
+
+/**
+ * TypeTraits namespace collects the compile time knowledge the vector uses to pick faster code paths
+ */
+namespace TypeTraits
+{
+	/**
+	 * A type is trivially relocatable if an object can be moved to another address with a plain memmove and
+	 * without calling any CCTOR / DTOR pair. Every trivially copyable type is, but many more types are (e.g. a class
+	 * that only owns a pointer to heap memory). Specialize this for such types to let the vector shift them with memmove
+	 */
+	template <typename T>
+	struct IsTriviallyRelocatable : std::integral_constant<bool, std::is_trivially_copyable<T>::value> {};
+
+	/**
+	 * Large vectors of types with this trait are copied on several threads at once. Trivially copyable types are just
+	 * memcpy'd, so they always are. Specialize this for types whose CCTOR is safe to run concurrently (no unsynchronized
+	 * shared state like non-atomic reference counts) to let them use the parallel copy path as well
+	 */
+	template <typename T>
+	struct IsParallelCopyConstructible : std::integral_constant<bool, std::is_trivially_copyable<T>::value> {};
+
+	/**
+	 * The destructor of a large vector of a type with this trait runs the DTORs on several threads at once.
+	 * Specialize this for types whose DTOR is safe to run concurrently. Trivially destructible types have no DTOR
+	 * to run, so they don't need it
+	 */
+	template <typename T>
+	struct IsParallelDestructible : std::false_type {};
+
+	/**
+	 * Two objects of a trivially comparable type are equal exactly if their bytes are, so vectors of them are compared
+	 * and hashed as raw memory. True for integers, enums and pointers, but not for floating point values (0.0 == -0.0,
+	 * NaN != NaN). Specialize this for structs without padding bytes whose operator== compares all members bitwise
+	 */
+	template <typename T>
+	struct IsTriviallyComparable : std::integral_constant<bool, std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value> {};
+}
+
+/**
+ * Parallel namespace holds the small work-stealing thread pool and the helpers the parallel algorithms are built on
+ * The calling thread always takes part in the work, so a machine with a single core just runs everything inline
+ */
+namespace Parallel
+{
+	size_t GetWorkerCount(void)
+	{
+		const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads ? hardwareThreads : 1u;
+	}
+
+	/**
+	 * ThreadPool keeps GetWorkerCount() - 1 threads alive for the whole process (the thread calling Run is the last
+	 * worker). Every thread owns a work queue: Run spreads its tasks over all queues, a thread takes the newest task
+	 * of its own queue and steals the oldest task of another queue once its own is empty, so uneven tasks balance out.
+	 * A task may call Run again, the waiting thread keeps executing tasks (its own or stolen ones) until its batch is done
+	 */
+	class ThreadPool
+	{
+	public:
+		typedef void (*TaskFunction)(void* context, size_t taskIndex);
+
+		static ThreadPool& Instance(void);
+
+		size_t GetThreadCount(void) const;
+		void Run(TaskFunction function, void* context, size_t taskCount);
+
+		~ThreadPool(void);
+
+	private:
+		explicit ThreadPool(size_t workerCount);
+		ThreadPool(const ThreadPool& other) = delete;
+		ThreadPool& operator=(const ThreadPool& other) = delete;
+
+		struct Task
+		{
+			TaskFunction function;
+			void* context;
+			size_t index;
+			std::atomic<size_t>* pendingTasks;
+		};
+
+		// Every queue is a small ring buffer of tasks. The task array keeps the mutex and counters of neighbouring
+		// queues far enough apart to not share a cache line
+		static const size_t QUEUE_CAPACITY = 1024;
+		struct WorkQueue
+		{
+			std::mutex mutex;
+			size_t first;
+			size_t count;
+			Task tasks[QUEUE_CAPACITY];
+		};
+
+		bool PushTask(size_t queueIndex, const Task& task);
+		bool PopTask(size_t queueIndex, Task& task);
+		bool StealTask(size_t thiefIndex, Task& task);
+		bool FindTask(size_t queueIndex, Task& task);
+		static void Execute(const Task& task);
+		size_t GetCurrentQueueIndex(void) const;
+		void WorkerLoop(size_t workerIndex);
+
+		// Queue of the current thread if it is one of our workers, threads from outside share the last queue
+		static thread_local size_t s_workerQueueIndex;
+
+		size_t m_workerCount;
+		WorkQueue* m_queues;
+		std::thread* m_workers;
+
+		std::atomic<size_t> m_queuedTasks;
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wakeUp;
+		bool m_shutdown;
+	};
+
+	thread_local size_t ThreadPool::s_workerQueueIndex = SIZE_MAX;
+
+	ThreadPool& ThreadPool::Instance()
+	{
+		static ThreadPool instance(GetWorkerCount() - 1u);
+		return instance;
+	}
+
+	ThreadPool::ThreadPool(size_t workerCount)
+		: m_workerCount(workerCount)
+		, m_queues(new WorkQueue[workerCount + 1u])
+		, m_workers(workerCount ? new std::thread[workerCount] : nullptr)
+		, m_queuedTasks(0u)
+		, m_shutdown(false)
+	{
+		for (size_t i = 0u; i <= m_workerCount; ++i)
+		{
+			m_queues[i].first = 0u;
+			m_queues[i].count = 0u;
+		}
+
+		for (size_t i = 0u; i < m_workerCount; ++i)
+		{
+			m_workers[i] = std::thread(&ThreadPool::WorkerLoop, this, i);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_shutdown = true;
+		}
+		m_wakeUp.notify_all();
+
+		for (size_t i = 0u; i < m_workerCount; ++i)
+		{
+			m_workers[i].join();
+		}
+		delete[] m_workers;
+		delete[] m_queues;
+	}
+
+	size_t ThreadPool::GetThreadCount() const
+	{
+		return m_workerCount + 1u;
+	}
+
+	/**
+	 * Calls function(context, i) for every i in [0, taskCount) and returns once all of them are done
+	 */
+	void ThreadPool::Run(TaskFunction function, void* context, size_t taskCount)
+	{
+		if (m_workerCount == 0u || taskCount <= 1u)
+		{
+			for (size_t i = 0u; i < taskCount; ++i)
+			{
+				function(context, i);
+			}
+			return;
+		}
+
+		std::atomic<size_t> pendingTasks(taskCount);
+		const size_t queueCount = m_workerCount + 1u;
+		const size_t homeQueue = GetCurrentQueueIndex();
+
+		// Every queue gets a share of the tasks to start with, stealing takes care of the rest.
+		// If a queue is full we run the task right away, that is the natural backpressure for huge task counts
+		size_t queuedTasks = 0u;
+		for (size_t i = 0u; i < taskCount; ++i)
+		{
+			const Task task = { function, context, i, &pendingTasks };
+			if (PushTask((homeQueue + i) % queueCount, task))
+			{
+				++queuedTasks;
+			}
+			else
+			{
+				Execute(task);
+			}
+		}
+
+		// PushTask already counted the tasks. Taking the sleep mutex orders the notification after the predicate check
+		// of every worker about to wait, so none of them can miss it
+		if (queuedTasks != 0u)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_sleepMutex);
+			}
+			m_wakeUp.notify_all();
+		}
+
+		while (pendingTasks.load(std::memory_order_acquire) != 0u)
+		{
+			Task task;
+			if (FindTask(homeQueue, task))
+			{
+				Execute(task);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	bool ThreadPool::PushTask(size_t queueIndex, const Task& task)
+	{
+		WorkQueue& queue = m_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.count == QUEUE_CAPACITY)
+		{
+			return false;
+		}
+
+		queue.tasks[(queue.first + queue.count) % QUEUE_CAPACITY] = task;
+		++queue.count;
+		// Counted under the queue lock, so a task is never popped or stolen before it is counted and the counter
+		// can't wrap below zero
+		m_queuedTasks.fetch_add(1u);
+		return true;
+	}
+
+	/**
+	 * The owner takes the newest task, it is the most likely one to still have its data in the cache
+	 */
+	bool ThreadPool::PopTask(size_t queueIndex, Task& task)
+	{
+		WorkQueue& queue = m_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.count == 0u)
+		{
+			return false;
+		}
+
+		--queue.count;
+		task = queue.tasks[(queue.first + queue.count) % QUEUE_CAPACITY];
+		m_queuedTasks.fetch_sub(1u);
+		return true;
+	}
+
+	/**
+	 * Thieves take the oldest task of the first non-empty queue behind their own one
+	 */
+	bool ThreadPool::StealTask(size_t thiefIndex, Task& task)
+	{
+		const size_t queueCount = m_workerCount + 1u;
+		for (size_t offset = 1u; offset < queueCount; ++offset)
+		{
+			WorkQueue& queue = m_queues[(thiefIndex + offset) % queueCount];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.count != 0u)
+			{
+				task = queue.tasks[queue.first];
+				queue.first = (queue.first + 1u) % QUEUE_CAPACITY;
+				--queue.count;
+				m_queuedTasks.fetch_sub(1u);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ThreadPool::FindTask(size_t queueIndex, Task& task)
+	{
+		return PopTask(queueIndex, task) || StealTask(queueIndex, task);
+	}
+
+	void ThreadPool::Execute(const Task& task)
+	{
+		task.function(task.context, task.index);
+		task.pendingTasks->fetch_sub(1u, std::memory_order_release);
+	}
+
+	size_t ThreadPool::GetCurrentQueueIndex() const
+	{
+		return s_workerQueueIndex < m_workerCount ? s_workerQueueIndex : m_workerCount;
+	}
+
+	void ThreadPool::WorkerLoop(size_t workerIndex)
+	{
+		s_workerQueueIndex = workerIndex;
+		for (;;)
+		{
+			Task task;
+			if (FindTask(workerIndex, task))
+			{
+				Execute(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_wakeUp.wait(lock, [this]() { return m_shutdown || m_queuedTasks.load() != 0u; });
+			if (m_shutdown && m_queuedTasks.load() == 0u)
+			{
+				return;
+			}
+		}
+	}
+
+	template <typename Work>
+	void CallWork(void* work, size_t block)
+	{
+		(*static_cast<Work*>(work))(block);
+	}
+
+	/**
+	 * Calls work(blockIndex) for every block in [0, blockCount) on the ThreadPool
+	 */
+	template <typename Work>
+	void ForEachBlock(size_t blockCount, Work work)
+	{
+		ThreadPool::Instance().Run(&CallWork<Work>, &work, blockCount);
+	}
+
+	/**
+	 * Splits [0, count) into blocks of blockSize elements and calls work(blockIndex, rangeBegin, rangeEnd) for each of them
+	 */
+	template <typename Work>
+	void ForEachRange(size_t count, size_t blockSize, Work work)
+	{
+		const size_t blockCount = (count + blockSize - 1u) / blockSize;
+		ForEachBlock(blockCount, [count, blockSize, &work](size_t block)
+		{
+			const size_t rangeBegin = block * blockSize;
+			const size_t rangeEnd = rangeBegin + blockSize < count ? rangeBegin + blockSize : count;
+			work(block, rangeBegin, rangeEnd);
+		});
+	}
+
+	/**
+	 * PageAlignedPartition splits the element range [rangeBegin, rangeEnd) of a page aligned array into blocks whose
+	 * borders lie on page boundaries. Only an element that straddles a border shares its page with the neighbouring
+	 * block, so every page is first touched by one worker (first-touch NUMA placement follows the workers) and workers
+	 * don't fight over cache lines. An element belongs to the block its first byte lies in.
+	 * Blocks are at least MIN_BLOCK_BYTES big, a range smaller than that is a single block and runs on the calling thread
+	 */
+	class PageAlignedPartition
+	{
+	public:
+		PageAlignedPartition(size_t rangeBegin, size_t rangeEnd, size_t elementSize, size_t pageSize);
+
+		size_t GetBlockCount(void) const;
+		// Returns false if the block holds no element (only possible for elements larger than a block)
+		bool GetBlock(size_t block, size_t& blockBegin, size_t& blockEnd) const;
+
+	private:
+		static const size_t MIN_BLOCK_BYTES = 256 * 1024;
+
+		size_t m_rangeBegin;
+		size_t m_rangeEnd;
+		size_t m_elementSize;
+		size_t m_blockBytes;
+		size_t m_firstBlock;
+		size_t m_blockCount;
+	};
+
+	PageAlignedPartition::PageAlignedPartition(size_t rangeBegin, size_t rangeEnd, size_t elementSize, size_t pageSize)
+		: m_rangeBegin(rangeBegin)
+		, m_rangeEnd(rangeEnd)
+		, m_elementSize(elementSize)
+		, m_blockBytes(0u)
+		, m_firstBlock(0u)
+		, m_blockCount(0u)
+	{
+		if (rangeEnd <= rangeBegin)
+		{
+			return;
+		}
+
+		// Four blocks per thread leave some room for stealing when blocks take different amounts of time
+		const size_t blockBytes = (rangeEnd - rangeBegin) * elementSize / (ThreadPool::Instance().GetThreadCount() * 4u);
+		m_blockBytes = MathUtil::roundUpToMultiple(blockBytes > MIN_BLOCK_BYTES ? blockBytes : MIN_BLOCK_BYTES, pageSize);
+
+		// Blocks are counted from the start of the array, so their borders are page aligned addresses
+		m_firstBlock = rangeBegin * elementSize / m_blockBytes;
+		m_blockCount = (rangeEnd - 1u) * elementSize / m_blockBytes + 1u - m_firstBlock;
+	}
+
+	size_t PageAlignedPartition::GetBlockCount() const
+	{
+		return m_blockCount;
+	}
+
+	bool PageAlignedPartition::GetBlock(size_t block, size_t& blockBegin, size_t& blockEnd) const
+	{
+		const size_t blockBeginByte = (m_firstBlock + block) * m_blockBytes;
+		blockBegin = (blockBeginByte + m_elementSize - 1u) / m_elementSize;
+		blockEnd = (blockBeginByte + m_blockBytes + m_elementSize - 1u) / m_elementSize;
+
+		blockBegin = blockBegin > m_rangeBegin ? blockBegin : m_rangeBegin;
+		blockEnd = blockEnd < m_rangeEnd ? blockEnd : m_rangeEnd;
+		return blockBegin < blockEnd;
+	}
+
+	/**
+	 * Calls work(blockIndex, blockBegin, blockEnd) for every non-empty block of the partition on the ThreadPool
+	 */
+	template <typename Work>
+	void ForEachPageAlignedBlock(const PageAlignedPartition& partition, Work work)
+	{
+		ForEachBlock(partition.GetBlockCount(), [&partition, &work](size_t block)
+		{
+			size_t blockBegin;
+			size_t blockEnd;
+			if (partition.GetBlock(block, blockBegin, blockEnd))
+			{
+				work(block, blockBegin, blockEnd);
+			}
+		});
+	}
+}
+
+namespace Expressions
+{
+	template <typename E> struct IsExpression;
+}
+
 template <typename T>
 class Vector
 {
@@ -89,10 +776,19 @@ class Vector
 	};
 
 public:
+	typedef T value_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
 	Vector(void);
 	Vector(const Vector<T>& other);
 	Vector<T>& operator=(const Vector<T>& other);
 
+	template <typename Expression, typename = typename std::enable_if<Expressions::IsExpression<Expression>::value>::type>
+	Vector(const Expression& expression);
+	template <typename Expression, typename = typename std::enable_if<Expressions::IsExpression<Expression>::value>::type>
+	Vector<T>& operator=(const Expression& expression);
+
 	size_t size(void) const;
 	size_t capacity(void) const;
 
@@ -102,24 +798,75 @@ public:
 
 	void resize(size_t newSize);
 	void resize(size_t newSize, const T& object);
+	void resize_uninitialized(size_t newSize);
+	void resize_zeroed(size_t newSize);
+	void resize_parallel(size_t newSize);
+	void resize_parallel(size_t newSize, const T& object);
+	void clear_parallel(void);
 
 	void reserve(size_t newCapacity);
 
 	void erase(size_t index);
 	void erase(size_t rangeBegin, size_t rangeEnd);
 	void erase_by_swap(size_t index);
+	void erase_by_swap(Vector<size_t>& indices);
+
+	template <typename Predicate>
+	size_t erase_if(Predicate predicate);
+	template <typename Predicate>
+	size_t erase_if_parallel(Predicate predicate);
+	void erase_indices(const Vector<size_t>& sortedIndices);
+
+	void insert(size_t index, const T& object);
+	void insert(size_t index, size_t count, const T& object);
+	template <typename ForwardIt, typename = typename std::enable_if<!std::is_integral<ForwardIt>::value>::type>
+	void insert(size_t index, ForwardIt first, ForwardIt last);
+
+	void pop_back(void);
 
 	T& operator[] (size_t index);
 	const T& operator[] (size_t index) const;
 
+	T& front(void);
+	const T& front(void) const;
+	T& back(void);
+	const T& back(void) const;
+
+	T* data(void);
+	const T* data(void) const;
+
+	iterator begin(void);
+	const_iterator begin(void) const;
+	iterator end(void);
+	const_iterator end(void) const;
+
+	void set_deferred_destruction(bool isDeferred);
+
 	~Vector(void);
 
 private:
 
 	void GrowByBytes(size_t growSizeInBytes);
+	void GrowToFit(size_t requiredCapacity);
 	size_t GetGrowSizeInElements(void) const;
 	size_t GetMaxElements(void) const;
 
+	template <typename Source>
+	void InsertFromSource(size_t index, size_t count, Source source);
+	void ShiftTail(size_t index, size_t count, std::true_type isTriviallyRelocatable);
+	void ShiftTail(size_t index, size_t count, std::false_type isTriviallyRelocatable);
+	void DestructTail(size_t newSize);
+	void DestructTailParallel(size_t newSize);
+	template <typename Work>
+	void ForEachPageAlignedRange(size_t rangeBegin, size_t rangeEnd, Work work);
+	void ZeroCommittedMemory(uintptr_t rangeBegin, uintptr_t rangeEnd);
+	static void DestroyElements(void* elements, size_t count);
+	void CopyElementsFrom(const Vector<T>& other);
+	static void CopyConstructRange(T* target, const T* source, size_t count, std::true_type isTriviallyCopyable);
+	static void CopyConstructRange(T* target, const T* source, size_t count, std::false_type isTriviallyCopyable);
+	static void DefaultConstructRange(T* elements, size_t rangeBegin, size_t rangeEnd, size_t pageSize, std::true_type isTriviallyDefaultConstructible);
+	static void DefaultConstructRange(T* elements, size_t rangeBegin, size_t rangeEnd, size_t pageSize, std::false_type isTriviallyDefaultConstructible);
+
 	size_t m_size;
 	size_t m_capacity;
 	size_t m_pageSize;
@@ -130,8 +877,16 @@ private:
 	PointerType m_physical_mem_end;
 	PointerType m_internal_array;
 
+	bool m_isDestructionDeferred;
+
 	//Maximum vector capacity as mentioned in lecture - 1GB
 	static const size_t MAX_VECTOR_CAPACITY = 1024 * 1024 * 1024;
+	//The address space is reserved with VirtualAlloc which always hands out page aligned (at least 4KB) memory
+	static const size_t MIN_PAGE_ALIGNMENT = 4096;
+	//Below this amount of elements per block the parallel algorithms are not worth the thread overhead
+	static const size_t MIN_PARALLEL_BLOCK_ELEMENTS = 4096;
+	//Dirty ranges of at least this many bytes are zeroed by decommitting and recommitting their pages instead of a memset
+	static const size_t ZERO_BY_DECOMMIT_THRESHOLD = 256 * 1024;
 };
 
 /**
@@ -147,10 +902,12 @@ Vector<T>::Vector()
 	, m_physical_mem_begin { m_virtual_mem_begin }
 	, m_physical_mem_end { m_virtual_mem_begin }
 	, m_internal_array { m_physical_mem_begin }
+	, m_isDestructionDeferred(false)
 {}
 
 /**
-* Copy Constructor just reserves enough space to hold the content of the other vector and then push_backs the elements
+* Copy Constructor just reserves enough space to hold the content of the other vector and then copies the elements.
+* Only the pages for other.size() elements are committed, the unused capacity of the other vector is not copied
 **/
 template <typename T>
 Vector<T>::Vector(const Vector<T>& other)
@@ -162,12 +919,10 @@ Vector<T>::Vector(const Vector<T>& other)
 	, m_physical_mem_begin { m_virtual_mem_begin }
 	, m_physical_mem_end { m_virtual_mem_begin }
 	, m_internal_array { m_physical_mem_begin }
+	, m_isDestructionDeferred(false)
 {
-	reserve(other.m_capacity);
-	for (size_t i = 0; i < other.m_size; ++i)
-	{
-		push_back((other[i]));
-	}
+	reserve(other.m_size);
+	CopyElementsFrom(other);
 }
 
 /**
@@ -191,21 +946,16 @@ Vector<T>& Vector<T>::operator=(const Vector<T>& other)
 			m_internal_array.as_element[i].~T();
 		}
 
-		// adjust capacity to match other vector only if the others capacity is larger than ours
-		// if it is lesser or equal we go with the current capacity and just copy in the others content
-		if (other.m_capacity > m_capacity)
+		// adjust capacity only if the others content does not fit into ours
+		// if it fits we go with the current capacity and just copy in the others content
+		if (other.m_size > m_capacity)
 		{
-			reserve(other.m_capacity);
+			reserve(other.m_size);
 		}
 
-		// need to set size to 0, so push_back will work correctly
-		m_size = 0u;
-
 		// copy everything from the other vector
-		for (size_t i = 0; i < other.m_size; ++i)
-		{
-			push_back((other[i]));
-		}
+		m_size = 0u;
+		CopyElementsFrom(other);
 	}
 
 	return *this;
@@ -213,18 +963,51 @@ Vector<T>& Vector<T>::operator=(const Vector<T>& other)
 
 /**
 * On destruction we call the dtors of all our elements and then release all pages and the
-* virtual address space
+* virtual address space. Types marked IsParallelDestructible are destroyed on all cores (small vectors are still
+* a single block on the calling thread, see Parallel::PageAlignedPartition)
 **/
 template <typename T>
 Vector<T>::~Vector()
 {
-	for (size_t i = 0u; i < m_size; ++i)
+	if (m_isDestructionDeferred)
 	{
-		m_internal_array.as_element[i].~T();
+		DeferredReclaimer::Instance().Enqueue(&Vector<T>::DestroyElements, m_internal_array.as_void, m_size,
+			m_virtual_mem_begin.as_void, m_physical_mem_end.as_ptr - m_physical_mem_begin.as_ptr);
+		return;
+	}
+
+	if (TypeTraits::IsParallelDestructible<T>::value)
+	{
+		DestructTailParallel(0u);
+	}
+	else
+	{
+		DestroyElements(m_internal_array.as_void, m_size);
 	}
 	VirtualMemory::FreeAddressSpace(m_virtual_mem_begin.as_void);
 }
 
+/**
+ * With deferred destruction enabled the destructor hands the elements and the reservation to the DeferredReclaimer
+ * thread instead of destroying them on the calling thread. Dropping a 1GB vector then only costs an enqueue (or a
+ * wait if the reclaimer is too far behind). The DTORs of T have to be safe to run on another thread
+ */
+template <typename T>
+void Vector<T>::set_deferred_destruction(bool isDeferred)
+{
+	m_isDestructionDeferred = isDeferred;
+}
+
+template <typename T>
+void Vector<T>::DestroyElements(void* elements, size_t count)
+{
+	T* const typedElements = static_cast<T*>(elements);
+	for (size_t i = 0u; i < count; ++i)
+	{
+		typedElements[i].~T();
+	}
+}
+
 template <typename T>
 size_t Vector<T>::size() const
 {
@@ -370,6 +1153,146 @@ void Vector<T>::resize(size_t newSize, const T& object)
 	m_size = newSize;
 }
 
+/**
+ * resize_uninitialized changes the size without touching the new elements at all. It is only available for types
+ * that can live in uninitialized memory (trivially default constructible and trivially destructible, e.g. int, float
+ * or plain structs of them), the caller is expected to write every new element before reading it.
+ * Growing 100M floats this way costs nothing but the page commits
+ */
+template <typename T>
+void Vector<T>::resize_uninitialized(size_t newSize)
+{
+	static_assert(std::is_trivially_default_constructible<T>::value && std::is_trivially_destructible<T>::value,
+		"resize_uninitialized requires a trivially default constructible and trivially destructible type");
+
+	{
+		bool resizeRequestExceedsAvailableRange = newSize > GetMaxElements();
+		assert("Resize requested more elements then the max capacity possible" && !resizeRequestExceedsAvailableRange);
+	}
+
+	if (newSize > m_capacity)
+	{
+		GrowByBytes((newSize - m_capacity) * sizeof(T));
+	}
+	m_size = newSize;
+}
+
+/**
+ * resize_zeroed works like resize_uninitialized but all new elements are guaranteed to be zero bytes (0, 0.0f, nullptr).
+ * Pages the OS commits for us are already zero-filled, so everything this call has to grow is not written at all.
+ * Only the part between the old size and the old end of the committed memory may hold old data and is zeroed,
+ * large ranges by handing the pages back to the OS and committing them again (see ZeroCommittedMemory)
+ */
+template <typename T>
+void Vector<T>::resize_zeroed(size_t newSize)
+{
+	static_assert(std::is_trivially_default_constructible<T>::value && std::is_trivially_destructible<T>::value,
+		"resize_zeroed requires a trivially default constructible and trivially destructible type");
+
+	{
+		bool resizeRequestExceedsAvailableRange = newSize > GetMaxElements();
+		assert("Resize requested more elements then the max capacity possible" && !resizeRequestExceedsAvailableRange);
+	}
+
+	if (newSize <= m_size)
+	{
+		m_size = newSize;
+		return;
+	}
+
+	// Everything behind the current end of the committed memory is fresh from the OS
+	const uintptr_t cleanMemoryBegin = m_physical_mem_end.as_ptr;
+	if (newSize > m_capacity)
+	{
+		GrowByBytes((newSize - m_capacity) * sizeof(T));
+	}
+
+	const uintptr_t dirtyBegin = m_internal_array.as_ptr + m_size * sizeof(T);
+	const uintptr_t newEnd = m_internal_array.as_ptr + newSize * sizeof(T);
+	ZeroCommittedMemory(dirtyBegin, newEnd < cleanMemoryBegin ? newEnd : cleanMemoryBegin);
+
+	m_size = newSize;
+}
+
+/**
+ * resize_parallel works like resize(size_t) but constructs (or destroys) the elements on all cores. The range is split
+ * into page aligned blocks, so every page is first written by exactly one worker: on NUMA machines the OS places a
+ * page on the node of the thread that touches it first, which keeps the pages close to the workers that built them.
+ * Default initialization of a trivial type does not write anything, so for those every worker writes a zero byte
+ * into each page of its block instead (see TouchPages).
+ * The DTORs / default CTORs of T have to be safe to call from several threads at once
+ */
+template <typename T>
+void Vector<T>::resize_parallel(size_t newSize)
+{
+	{
+		bool resizeRequestExceedsAvailableRange = newSize > GetMaxElements();
+		assert("Resize requested more elements then the max capacity possible" && !resizeRequestExceedsAvailableRange);
+	}
+
+	if (newSize <= m_size)
+	{
+		DestructTailParallel(newSize);
+		return;
+	}
+
+	if (newSize > m_capacity)
+	{
+		GrowByBytes((newSize - m_capacity) * sizeof(T));
+	}
+
+	T* const elements = m_internal_array.as_element;
+	const size_t pageSize = m_pageSize;
+	ForEachPageAlignedRange(m_size, newSize, [elements, pageSize](size_t rangeBegin, size_t rangeEnd)
+	{
+		DefaultConstructRange(elements, rangeBegin, rangeEnd, pageSize, std::is_trivially_default_constructible<T>());
+	});
+	m_size = newSize;
+}
+
+/**
+ * Parallel version of resize(size_t, const T&), all workers copy construct from the same template object
+ */
+template <typename T>
+void Vector<T>::resize_parallel(size_t newSize, const T& object)
+{
+	{
+		bool resizeRequestExceedsAvailableRange = newSize > GetMaxElements();
+		assert("Resize requested more elements then the max capacity possible" && !resizeRequestExceedsAvailableRange);
+	}
+
+	if (newSize <= m_size)
+	{
+		DestructTailParallel(newSize);
+		return;
+	}
+
+	if (newSize > m_capacity)
+	{
+		GrowByBytes((newSize - m_capacity) * sizeof(T));
+	}
+
+	T* const elements = m_internal_array.as_element;
+	ForEachPageAlignedRange(m_size, newSize, [elements, &object](size_t rangeBegin, size_t rangeEnd)
+	{
+		for (size_t i = rangeBegin; i < rangeEnd; ++i)
+		{
+			new (elements + i) T(object);
+		}
+	});
+	m_size = newSize;
+}
+
+/**
+ * Destroys all elements on all cores and keeps the capacity. Calling this before a huge vector goes out of scope
+ * moves the expensive part of its destruction off the single threaded destructor
+ */
+template <typename T>
+void Vector<T>::clear_parallel()
+{
+	DestructTailParallel(0u);
+}
+
 /**
  * In reserve(size_t) we try to aquire new resources to fit the requested capacity. If we already have grown big enough
  * we have to do nothing. If we don't fit, we grow the internal array by requesting more physical memory from our
@@ -501,340 +1424,7503 @@ void Vector<T>::erase_by_swap(size_t index)
 	--m_size;
 }
 
+/**
+ * The batched erase_by_swap removes all elements at the given (unsorted) indices without keeping the order.
+ * Calling erase_by_swap(index) in a loop is fiddly because each swap moves the last element, which might be one
+ * of the later targets. Instead we look at the final layout directly: with k unique indices the vector ends at
+ * size - k, every target in front of that is a hole and every non-target behind it is a survivor that has to fill
+ * one of the holes. That is the minimum work possible: one assignment per hole and exactly k DTOR calls.
+ * Duplicate indices are ignored. The indices are sorted in place (a copy would reserve and release a whole address
+ * range on every call): afterwards indices holds the erased indices sorted and without duplicates
+ */
 template <typename T>
-T& Vector<T>::operator[](size_t index)
+void Vector<T>::erase_by_swap(Vector<size_t>& indices)
 {
-	//No check for >= 0 needed because index is unsigned!
-	assert("Subscript out of range!" && index < m_size);
-	return m_internal_array.as_element[index];
+	if (indices.empty())
+	{
+		return;
+	}
+
+	// Sorting the indices resolves all conflicts up front, they are a lot cheaper to sort than the elements to move
+	size_t* const sortedBegin = indices.data();
+	std::sort(sortedBegin, sortedBegin + indices.size());
+	const size_t eraseCount = static_cast<size_t>(std::unique(sortedBegin, sortedBegin + indices.size()) - sortedBegin);
+	indices.resize(eraseCount);
+
+	{
+		//Check if the largest index is in Range, no negative check needed because size_t is unsigned
+		const bool isIndexInRange = sortedBegin[eraseCount - 1u] < m_size;
+		assert("Index out of Range!" && isIndexInRange);
+	}
+
+	const size_t newSize = m_size - eraseCount;
+
+	// Targets behind newSize are sorted at the back of the index list, we skip them while looking for survivors
+	size_t tailTarget = static_cast<size_t>(std::lower_bound(sortedBegin, sortedBegin + eraseCount, newSize) - sortedBegin);
+	size_t survivor = newSize;
+	for (size_t hole = 0u; hole < eraseCount && sortedBegin[hole] < newSize; ++hole)
+	{
+		while (tailTarget < eraseCount && sortedBegin[tailTarget] == survivor)
+		{
+			++tailTarget;
+			++survivor;
+		}
+
+		m_internal_array.as_element[sortedBegin[hole]] = m_internal_array.as_element[survivor];
+		++survivor;
+	}
+
+	DestructTail(newSize);
 }
 
+/**
+ * erase_if removes every element the predicate returns true for while keeping the order of the remaining ones.
+ * Unlike calling erase(index) in a loop (which shifts the whole tail on every call) this is a single compaction pass:
+ * every kept element is assigned at most once to its final slot and the DTORs are only called for the trailing slots
+ * that are left over at the end. Returns the amount of erased elements
+ */
 template <typename T>
-const T& Vector<T>::operator[](size_t index) const
+template <typename Predicate>
+size_t Vector<T>::erase_if(Predicate predicate)
 {
-	//No check for >= 0 needed because index is unsigned!
-	assert("Subscript out of range!" && index < m_size);
-	return m_internal_array.as_element[index];
+	size_t write = 0u;
+	for (size_t read = 0u; read < m_size; ++read)
+	{
+		if (!predicate(static_cast<const T&>(m_internal_array.as_element[read])))
+		{
+			if (write != read)
+			{
+				m_internal_array.as_element[write] = m_internal_array.as_element[read];
+			}
+			++write;
+		}
+	}
+
+	const size_t erasedCount = m_size - write;
+	DestructTail(write);
+	return erasedCount;
 }
 
 /**
- * GrowByBytes is an internal function used to get more physical memory for the
- * prereserved virtual address space. 
+ * The parallel version of erase_if for large vectors. The predicate has to be safe to call from several threads.
+ * - Pass 1 (parallel): every block compacts its kept elements to its own front and counts them
+ * - An exclusive prefix sum over the block counts gives every block the final offset of its elements
+ * - Pass 2: the compacted blocks are moved down to their offsets in ascending order, this is a plain block copy
+ *   and only touches the kept elements (the expensive predicate calls all happened in parallel)
+ * The result is the same as the one of erase_if
  */
 template <typename T>
-void Vector<T>::GrowByBytes(size_t growSizeInBytes)
+template <typename Predicate>
+size_t Vector<T>::erase_if_parallel(Predicate predicate)
 {
-	if (growSizeInBytes == 0u) return; // Grows by 0 are just rejected
-	
-	// Round up to the next highest multiple of the current OS page size
-	size_t roundedGrowSize = MathUtil::roundUpToMultiple(growSizeInBytes, m_pageSize);
-
+	const size_t workerCount = Parallel::GetWorkerCount();
+	size_t blockSize = m_size / (workerCount * 4u);
+	blockSize = blockSize > MIN_PARALLEL_BLOCK_ELEMENTS ? blockSize : MIN_PARALLEL_BLOCK_ELEMENTS;
+	if (m_size <= blockSize)
 	{
-		// If the grow would exceed the available address space we cannot grow anymore
-		// this happends if the m_physical_mem pointer is already at the m_virtual_end
-		const bool addressSpaceEndReached = m_physical_mem_end.as_ptr == m_virtual_mem_end.as_ptr;
-		assert("Grow would exceed maximum available address space - cannot grow further!" && !addressSpaceEndReached);
+		return erase_if(predicate);
 	}
 
-	// We though about this and decided it makes sense that if a user
-	// push_backs into the vector and the grow behaviour would exceed the range
-	// then we allow growing to the maximum available address space and just fail to
-	// grow if we really are out of memory
-	if (m_physical_mem_end.as_ptr + roundedGrowSize > m_virtual_mem_end.as_ptr)
+	const size_t blockCount = (m_size + blockSize - 1u) / blockSize;
+	Vector<size_t> keptPerBlock;
+	keptPerBlock.resize(blockCount);
+
+	T* const elements = m_internal_array.as_element;
+	Parallel::ForEachRange(m_size, blockSize, [elements, &predicate, &keptPerBlock](size_t block, size_t rangeBegin, size_t rangeEnd)
 	{
-		size_t remainingGrowSpace = m_virtual_mem_end.as_ptr - m_physical_mem_end.as_ptr;
-		roundedGrowSize = MathUtil::roundDownToMultiple(remainingGrowSpace, m_pageSize);
+		size_t write = rangeBegin;
+		for (size_t read = rangeBegin; read < rangeEnd; ++read)
+		{
+			if (!predicate(static_cast<const T&>(elements[read])))
+			{
+				if (write != read)
+				{
+					elements[write] = elements[read];
+				}
+				++write;
+			}
+		}
+		keptPerBlock[block] = write - rangeBegin;
+	});
+
+	// Exclusive prefix sum turns the counts into destination offsets, block 0 is already in place
+	size_t offset = keptPerBlock[0];
+	for (size_t block = 1u; block < blockCount; ++block)
+	{
+		const size_t kept = keptPerBlock[block];
+		const size_t rangeBegin = block * blockSize;
+		if (offset != rangeBegin)
+		{
+			for (size_t i = 0u; i < kept; ++i)
+			{
+				elements[offset + i] = elements[rangeBegin + i];
+			}
+		}
+		offset += kept;
 	}
 
-	PointerType allocation;
-	allocation.as_void = VirtualMemory::GetPhysicalMemory(m_physical_mem_end.as_void, roundedGrowSize);
-	m_physical_mem_end.as_ptr = allocation.as_ptr + roundedGrowSize;
-	// If the range is not equally divisable by the sizeof(T) this implicitely does a floor(...)
-	// and we are good because we don't say that we have more capacity than we really have
-	m_capacity = (m_physical_mem_end.as_ptr - m_physical_mem_begin.as_ptr) / sizeof(T);
+	const size_t erasedCount = m_size - offset;
+	DestructTail(offset);
+	return erasedCount;
 }
 
+/**
+ * erase_indices removes all elements at the given indices in a single stable compaction pass (see erase_if).
+ * The indices have to be sorted ascending and must not contain duplicates
+ */
 template <typename T>
-size_t Vector<T>::GetGrowSizeInElements() const
+void Vector<T>::erase_indices(const Vector<size_t>& sortedIndices)
 {
-	// This is a small trick we found in a blog and thought about a bit
-	// If we allocate one element it is very probable that we allocate a few more and 
-	// it shows a small performance gain when allocating 8 slots at the beginning instead of going 1-2-4-8 for the first few push_backs
-	// INFO: This is a better optimization for a non virtual mem based vector implementation but we leave it here as a reference to think
-	// about this kind of micro-opts when virtual mem would not be a thing (thank `eternal thing` it is)
-	return m_capacity ? m_capacity * 2 : 8;
+	const size_t indexCount = sortedIndices.size();
+	if (indexCount == 0u)
+	{
+		return;
+	}
+
+	{
+		for (size_t i = 0u; i < indexCount; ++i)
+		{
+			const bool isIndexInRange = sortedIndices[i] < m_size;
+			assert("Index out of Range!" && isIndexInRange);
+			const bool isSortedAndUnique = i == 0u || sortedIndices[i - 1u] < sortedIndices[i];
+			assert("Indices need to be sorted ascending and unique!" && isSortedAndUnique);
+		}
+	}
+
+	// Everything in front of the first index stays where it is
+	size_t write = sortedIndices[0];
+	size_t nextIndex = 0u;
+	for (size_t read = write; read < m_size; ++read)
+	{
+		if (nextIndex < indexCount && sortedIndices[nextIndex] == read)
+		{
+			++nextIndex;
+			continue;
+		}
+
+		m_internal_array.as_element[write] = m_internal_array.as_element[read];
+		++write;
+	}
+
+	DestructTail(write);
 }
 
 /**
-* Convenient function to retrieve the maximum amount of elements this vector can ever hold
-**/
-template<typename T>
-size_t Vector<T>::GetMaxElements(void) const
+ * Insert places copies of the object at index and shifts every element behind it to the back. All three overloads
+ * share InsertFromSource so the vector grows at most once and the tail is shifted exactly once, no matter how many
+ * elements are inserted. Inserting at index == size() is the same as a push_back
+ */
+template <typename T>
+void Vector<T>::insert(size_t index, const T& object)
 {
-	return MAX_VECTOR_CAPACITY / sizeof(T);
+	insert(index, 1u, object);
 }
 
-/// ++++++++++++++++++++++++++++++++++++++++++
-/// ++++++++++++++ TEST PROGRAM ++++++++++++++
-/// ++++++++++++++++++++++++++++++++++++++++++
-
-namespace UnitTests
+template <typename T>
+void Vector<T>::insert(size_t index, size_t count, const T& object)
 {
-	void Construction()
+	// If object lives inside of this vector the tail shift could overwrite it before we copied it
+	// into the gap, so we take a copy first (the memory itself never moves, we don't reallocate)
+	if (&object >= m_internal_array.as_element && &object < m_internal_array.as_element + m_size)
 	{
-		Vector<int> intVec;
-		assert("Initial capacity was not 0" && intVec.capacity() == 0);
-		assert("Initial size was not 0" && intVec.size() == 0);
+		const T copy(object);
+		InsertFromSource(index, count, [&copy]() -> const T& { return copy; });
+		return;
 	}
 
-	void CopyConstruction()
-	{
-		Vector<size_t> firstVector;
+	InsertFromSource(index, count, [&object]() -> const T& { return object; });
+}
 
-		firstVector.push_back(123u);
-		firstVector.push_back(456u);
-		firstVector.push_back(789u);
-		firstVector.push_back(123456789u);
+/**
+ * The range must not point into this vector. We need the length of the range up front to grow once and open the gap
+ * in one pass, so the iterators have to be at least forward iterators (raw pointers are fine)
+ */
+template <typename T>
+template <typename ForwardIt, typename>
+void Vector<T>::insert(size_t index, ForwardIt first, ForwardIt last)
+{
+	const size_t count = static_cast<size_t>(std::distance(first, last));
+	InsertFromSource(index, count, [&first]() -> const T& { return *first++; });
+}
 
-		Vector<size_t> testVector(firstVector);
-		assert("Vector size mismatch" && firstVector.size() == testVector.size());
-		assert("Vector capacity mismatch" && firstVector.capacity() == testVector.capacity());
+/**
+ * The shared insert implementation. source() is called once per new element, in ascending index order.
+ * After ShiftTail every slot of the gap below the old size still holds a living object (it gets assigned)
+ * and every slot at or above the old size is raw memory (it gets copy constructed) - for relocatable types
+ * the whole gap is raw memory because the tail was moved with memmove
+ */
+template <typename T>
+template <typename Source>
+void Vector<T>::InsertFromSource(size_t index, size_t count, Source source)
+{
+	{
+		const bool isIndexInRange = index <= m_size;
+		assert("Insert index out of Range!" && isIndexInRange);
+		const bool insertExceedsAvailableRange = count > GetMaxElements() - m_size;
+		assert("Insert requested more elements then the max capacity possible" && !insertExceedsAvailableRange);
+	}
 
-		assert(testVector[0] == 123u);
-		assert(testVector[1] == 456u);
-		assert(testVector[2] == 789u);
-		assert(testVector[3] == 123456789u);
+	if (count == 0u)
+	{
+		return;
 	}
 
-	void Assignment()
+	GrowToFit(m_size + count);
+
+	const size_t oldSize = m_size;
+	const bool isRelocatable = TypeTraits::IsTriviallyRelocatable<T>::value;
+	ShiftTail(index, count, std::integral_constant<bool, TypeTraits::IsTriviallyRelocatable<T>::value>());
+
+	PointerType targetPtr;
+	for (size_t i = index; i < index + count; ++i)
+	{
+		if (!isRelocatable && i < oldSize)
+		{
+			m_internal_array.as_element[i] = source();
+		}
+		else
+		{
+			targetPtr.as_ptr = m_internal_array.as_ptr + i * sizeof(T);
+			new (targetPtr.as_void) T(source());
+		}
+	}
+
+	m_size = oldSize + count;
+}
+
+/**
+ * Relocatable types are shifted with a single memmove, this leaves a gap of raw memory behind
+ */
+template <typename T>
+void Vector<T>::ShiftTail(size_t index, size_t count, std::true_type)
+{
+	if (index < m_size)
+	{
+		std::memmove(m_internal_array.as_element + index + count, m_internal_array.as_element + index, (m_size - index) * sizeof(T));
+	}
+}
+
+/**
+ * All other types are shifted back to front: slots behind the old size are copy constructed, all others are assigned
+ * (the same CCTOR / assignment OP requirements std::vector::insert has)
+ */
+template <typename T>
+void Vector<T>::ShiftTail(size_t index, size_t count, std::false_type)
+{
+	PointerType targetPtr;
+	for (size_t i = m_size; i > index; --i)
+	{
+		const size_t source = i - 1;
+		const size_t destination = source + count;
+		if (destination >= m_size)
+		{
+			targetPtr.as_ptr = m_internal_array.as_ptr + destination * sizeof(T);
+			new (targetPtr.as_void) T(m_internal_array.as_element[source]);
+		}
+		else
+		{
+			m_internal_array.as_element[destination] = m_internal_array.as_element[source];
+		}
+	}
+}
+
+/**
+ * pop_back removes the last element by calling its DTOR, the capacity stays the same
+ */
+template <typename T>
+void Vector<T>::pop_back()
+{
+	assert("pop_back called on an empty vector!" && m_size != 0u);
+	m_internal_array.as_element[m_size - 1u].~T();
+	--m_size;
+}
+
+template <typename T>
+T& Vector<T>::operator[](size_t index)
+{
+	//No check for >= 0 needed because index is unsigned!
+	assert("Subscript out of range!" && index < m_size);
+	return m_internal_array.as_element[index];
+}
+
+template <typename T>
+const T& Vector<T>::operator[](size_t index) const
+{
+	//No check for >= 0 needed because index is unsigned!
+	assert("Subscript out of range!" && index < m_size);
+	return m_internal_array.as_element[index];
+}
+
+template <typename T>
+T& Vector<T>::front()
+{
+	assert("front called on an empty vector!" && m_size != 0u);
+	return m_internal_array.as_element[0];
+}
+
+template <typename T>
+const T& Vector<T>::front() const
+{
+	assert("front called on an empty vector!" && m_size != 0u);
+	return m_internal_array.as_element[0];
+}
+
+template <typename T>
+T& Vector<T>::back()
+{
+	assert("back called on an empty vector!" && m_size != 0u);
+	return m_internal_array.as_element[m_size - 1u];
+}
+
+template <typename T>
+const T& Vector<T>::back() const
+{
+	assert("back called on an empty vector!" && m_size != 0u);
+	return m_internal_array.as_element[m_size - 1u];
+}
+
+/**
+ * data() gives direct access to the contiguous elements. Unlike operator[] there is no assert and no PointerType
+ * in between, and the internal array always starts at the beginning of our page aligned reservation, which we pass
+ * on to the compiler so loops over the raw pointer can be vectorized with aligned loads
+ */
+template <typename T>
+T* Vector<T>::data()
+{
+	return CompilerHints::AssumeAligned<MIN_PAGE_ALIGNMENT>(m_internal_array.as_element);
+}
+
+template <typename T>
+const T* Vector<T>::data() const
+{
+	return CompilerHints::AssumeAligned<MIN_PAGE_ALIGNMENT>(static_cast<const T*>(m_internal_array.as_element));
+}
+
+/**
+ * The iterators are plain pointers into the internal array. They are contiguous random access iterators, so all the
+ * standard algorithms (std::sort, std::transform, ...) work on the vector. Like std::vector, the iterators stay valid
+ * as long as the element they point to is not erased - the vector never moves its memory when it grows
+ */
+template <typename T>
+typename Vector<T>::iterator Vector<T>::begin()
+{
+	return data();
+}
+
+template <typename T>
+typename Vector<T>::const_iterator Vector<T>::begin() const
+{
+	return data();
+}
+
+template <typename T>
+typename Vector<T>::iterator Vector<T>::end()
+{
+	return data() + m_size;
+}
+
+template <typename T>
+typename Vector<T>::const_iterator Vector<T>::end() const
+{
+	return data() + m_size;
+}
+
+/**
+ * GrowByBytes is an internal function used to get more physical memory for the
+ * prereserved virtual address space. 
+ */
+template <typename T>
+void Vector<T>::GrowByBytes(size_t growSizeInBytes)
+{
+	if (growSizeInBytes == 0u) return; // Grows by 0 are just rejected
+	
+	// Round up to the next highest multiple of the current OS page size
+	size_t roundedGrowSize = MathUtil::roundUpToMultiple(growSizeInBytes, m_pageSize);
+
+	{
+		// If the grow would exceed the available address space we cannot grow anymore
+		// this happends if the m_physical_mem pointer is already at the m_virtual_end
+		const bool addressSpaceEndReached = m_physical_mem_end.as_ptr == m_virtual_mem_end.as_ptr;
+		assert("Grow would exceed maximum available address space - cannot grow further!" && !addressSpaceEndReached);
+	}
+
+	// We though about this and decided it makes sense that if a user
+	// push_backs into the vector and the grow behaviour would exceed the range
+	// then we allow growing to the maximum available address space and just fail to
+	// grow if we really are out of memory
+	if (m_physical_mem_end.as_ptr + roundedGrowSize > m_virtual_mem_end.as_ptr)
+	{
+		size_t remainingGrowSpace = m_virtual_mem_end.as_ptr - m_physical_mem_end.as_ptr;
+		roundedGrowSize = MathUtil::roundDownToMultiple(remainingGrowSpace, m_pageSize);
+	}
+
+	PointerType allocation;
+	allocation.as_void = VirtualMemory::GetPhysicalMemory(m_physical_mem_end.as_void, roundedGrowSize);
+	m_physical_mem_end.as_ptr = allocation.as_ptr + roundedGrowSize;
+	// If the range is not equally divisable by the sizeof(T) this implicitely does a floor(...)
+	// and we are good because we don't say that we have more capacity than we really have
+	m_capacity = (m_physical_mem_end.as_ptr - m_physical_mem_begin.as_ptr) / sizeof(T);
+}
+
+/**
+ * Calls the DTORs of all elements behind newSize and shrinks the size to newSize, the capacity stays the same
+ */
+template <typename T>
+void Vector<T>::DestructTail(size_t newSize)
+{
+	for (size_t i = newSize; i < m_size; ++i)
+	{
+		m_internal_array.as_element[i].~T();
+	}
+	m_size = newSize;
+}
+
+/**
+ * Copy constructs the elements of other into our (empty) internal array, the capacity has to fit already.
+ * Large vectors are copied in page aligned blocks on all cores (see ForEachPageAlignedRange), so a copy of a huge
+ * vector is limited by memory bandwidth instead of a single thread. Trivially copyable types use memcpy per block
+ */
+template <typename T>
+void Vector<T>::CopyElementsFrom(const Vector<T>& other)
+{
+	T* const target = m_internal_array.as_element;
+	const T* const source = other.m_internal_array.as_element;
+	typedef std::integral_constant<bool, std::is_trivially_copyable<T>::value> IsTriviallyCopyable;
+
+	if (TypeTraits::IsParallelCopyConstructible<T>::value)
+	{
+		ForEachPageAlignedRange(0u, other.m_size, [target, source](size_t rangeBegin, size_t rangeEnd)
+		{
+			CopyConstructRange(target + rangeBegin, source + rangeBegin, rangeEnd - rangeBegin, IsTriviallyCopyable());
+		});
+	}
+	else
+	{
+		CopyConstructRange(target, source, other.m_size, IsTriviallyCopyable());
+	}
+	m_size = other.m_size;
+}
+
+template <typename T>
+void Vector<T>::CopyConstructRange(T* target, const T* source, size_t count, std::true_type)
+{
+	if (count != 0u)
+	{
+		std::memcpy(target, source, count * sizeof(T));
+	}
+}
+
+template <typename T>
+void Vector<T>::CopyConstructRange(T* target, const T* source, size_t count, std::false_type)
+{
+	for (size_t i = 0u; i < count; ++i)
+	{
+		new (target + i) T(source[i]);
+	}
+}
+
+/**
+ * Default initializing a trivial type is a no-op, the compiler drops the loop and the new pages would be first touched
+ * by whoever writes them later. We write one zero byte per page of the range (the value of a default initialized
+ * element is indeterminate anyway), so the calling worker faults them in. Only bytes of elements in the range are
+ * written, the first one and every page start behind it
+ */
+template <typename T>
+void Vector<T>::DefaultConstructRange(T* elements, size_t rangeBegin, size_t rangeEnd, size_t pageSize, std::true_type)
+{
+	const uintptr_t bytesEnd = reinterpret_cast<uintptr_t>(elements + rangeEnd);
+	for (uintptr_t byte = reinterpret_cast<uintptr_t>(elements + rangeBegin); byte < bytesEnd; byte = MathUtil::roundDownToMultiple(byte, pageSize) + pageSize)
+	{
+		*reinterpret_cast<volatile uint8_t*>(byte) = 0u;
+	}
+}
+
+template <typename T>
+void Vector<T>::DefaultConstructRange(T* elements, size_t rangeBegin, size_t rangeEnd, size_t, std::false_type)
+{
+	for (size_t i = rangeBegin; i < rangeEnd; ++i)
+	{
+		// Default initialization just like resize(size_t)
+		new (elements + i) T;
+	}
+}
+
+/**
+ * Parallel version of DestructTail, types without a DTOR are not touched at all
+ */
+template <typename T>
+void Vector<T>::DestructTailParallel(size_t newSize)
+{
+	if (!std::is_trivially_destructible<T>::value)
+	{
+		T* const elements = m_internal_array.as_element;
+		ForEachPageAlignedRange(newSize, m_size, [elements](size_t rangeBegin, size_t rangeEnd)
+		{
+			for (size_t i = rangeBegin; i < rangeEnd; ++i)
+			{
+				elements[i].~T();
+			}
+		});
+	}
+	m_size = newSize < m_size ? newSize : m_size;
+}
+
+/**
+ * Calls work(blockBegin, blockEnd) in parallel for the page aligned blocks of [rangeBegin, rangeEnd), see
+ * Parallel::PageAlignedPartition. The internal array starts at the beginning of our reservation, so it is page aligned
+ */
+template <typename T>
+template <typename Work>
+void Vector<T>::ForEachPageAlignedRange(size_t rangeBegin, size_t rangeEnd, Work work)
+{
+	const Parallel::PageAlignedPartition partition(rangeBegin, rangeEnd, sizeof(T), m_pageSize);
+	Parallel::ForEachPageAlignedBlock(partition, [&work](size_t, size_t blockBegin, size_t blockEnd)
+	{
+		work(blockBegin, blockEnd);
+	});
+}
+
+/**
+ * Zeroes a range of already committed memory. Small ranges are just memset, for large ones we memset the partial
+ * pages at the borders and decommit / recommit all full pages in between: the OS hands them back zero-filled on
+ * first access, so we neither write nor even touch them here
+ */
+template <typename T>
+void Vector<T>::ZeroCommittedMemory(uintptr_t rangeBegin, uintptr_t rangeEnd)
+{
+	if (rangeEnd <= rangeBegin)
+	{
+		return;
+	}
+
+	const uintptr_t fullPagesBegin = MathUtil::roundUpToMultiple(rangeBegin, m_pageSize);
+	const uintptr_t fullPagesEnd = MathUtil::roundDownToMultiple(rangeEnd, m_pageSize);
+	if (rangeEnd - rangeBegin < ZERO_BY_DECOMMIT_THRESHOLD || fullPagesEnd <= fullPagesBegin)
+	{
+		std::memset(reinterpret_cast<void*>(rangeBegin), 0, rangeEnd - rangeBegin);
+		return;
+	}
+
+	std::memset(reinterpret_cast<void*>(rangeBegin), 0, fullPagesBegin - rangeBegin);
+	VirtualMemory::FreePhysicalMemory(reinterpret_cast<void*>(fullPagesBegin), fullPagesEnd - fullPagesBegin);
+	VirtualMemory::GetPhysicalMemory(reinterpret_cast<void*>(fullPagesBegin), fullPagesEnd - fullPagesBegin);
+	std::memset(reinterpret_cast<void*>(fullPagesEnd), 0, rangeEnd - fullPagesEnd);
+}
+
+/**
+ * GrowToFit makes sure the capacity can hold requiredCapacity elements with a single grow. We grow by at least
+ * the default grow size so a series of small inserts does not commit page by page
+ */
+template <typename T>
+void Vector<T>::GrowToFit(size_t requiredCapacity)
+{
+	if (requiredCapacity <= m_capacity)
+	{
+		return;
+	}
+
+	const size_t missingElements = requiredCapacity - m_capacity;
+	const size_t defaultGrowElements = GetGrowSizeInElements();
+	GrowByBytes((missingElements > defaultGrowElements ? missingElements : defaultGrowElements) * sizeof(T));
+}
+
+template <typename T>
+size_t Vector<T>::GetGrowSizeInElements() const
+{
+	// This is a small trick we found in a blog and thought about a bit
+	// If we allocate one element it is very probable that we allocate a few more and 
+	// it shows a small performance gain when allocating 8 slots at the beginning instead of going 1-2-4-8 for the first few push_backs
+	// INFO: This is a better optimization for a non virtual mem based vector implementation but we leave it here as a reference to think
+	// about this kind of micro-opts when virtual mem would not be a thing (thank `eternal thing` it is)
+	return m_capacity ? m_capacity * 2 : 8;
+}
+
+/**
+* Convenient function to retrieve the maximum amount of elements this vector can ever hold
+**/
+template<typename T>
+size_t Vector<T>::GetMaxElements(void) const
+{
+	return MAX_VECTOR_CAPACITY / sizeof(T);
+}
+
+/**
+ * parallel_for calls function(element) for every element of the vector on the ThreadPool. The vector is split into
+ * page aligned chunks (see Parallel::PageAlignedPartition), idle threads steal chunks from busy ones.
+ * function has to be safe to call from several threads at once
+ */
+template <typename T, typename Function>
+void parallel_for(Vector<T>& vector, Function function)
+{
+	T* const elements = vector.data();
+	const Parallel::PageAlignedPartition partition(0u, vector.size(), sizeof(T), VirtualMemory::GetPageSize());
+	Parallel::ForEachPageAlignedBlock(partition, [elements, &function](size_t, size_t blockBegin, size_t blockEnd)
+	{
+		for (size_t i = blockBegin; i < blockEnd; ++i)
+		{
+			function(elements[i]);
+		}
+	});
+}
+
+/**
+ * parallel_reduce combines all elements of the vector with op, starting from init. Every chunk is reduced on its own
+ * (starting with its first element), then init and the chunk results are combined in chunk order, so the result
+ * does not depend on the thread scheduling. Requirements:
+ * - op(Result, const T&) and op(Result, Result) both return a Result, T is convertible to Result
+ * - op is associative (the elements are not combined strictly left to right), e.g. sum, min, max
+ */
+template <typename T, typename Result, typename Op>
+Result parallel_reduce(const Vector<T>& vector, Result init, Op op)
+{
+	const T* const elements = vector.data();
+	const Parallel::PageAlignedPartition partition(0u, vector.size(), sizeof(T), VirtualMemory::GetPageSize());
+	const size_t blockCount = partition.GetBlockCount();
+
+	// Partial results live in raw memory, Result does not need a default CTOR
+	Vector<uint8_t> partialStorage;
+	partialStorage.resize_uninitialized(blockCount * sizeof(Result));
+	Result* const partials = reinterpret_cast<Result*>(partialStorage.data());
+	Vector<uint8_t> hasPartial;
+	hasPartial.resize_zeroed(blockCount);
+	uint8_t* const hasPartialFlags = hasPartial.data();
+
+	Parallel::ForEachPageAlignedBlock(partition, [elements, partials, hasPartialFlags, &op](size_t block, size_t blockBegin, size_t blockEnd)
+	{
+		Result partial = elements[blockBegin];
+		for (size_t i = blockBegin + 1u; i < blockEnd; ++i)
+		{
+			partial = op(partial, elements[i]);
+		}
+		new (partials + block) Result(partial);
+		hasPartialFlags[block] = 1u;
+	});
+
+	Result result = init;
+	for (size_t block = 0u; block < blockCount; ++block)
+	{
+		if (hasPartialFlags[block])
+		{
+			result = op(result, partials[block]);
+			partials[block].~Result();
+		}
+	}
+	return result;
+}
+
+/**
+ * Sorting namespace holds the building blocks of radix_sort and parallel_sort
+ */
+namespace Sorting
+{
+	/**
+	 * RadixKey maps a value to an unsigned integer of the same size whose unsigned order is the order of the values:
+	 * - unsigned integers are their own key
+	 * - signed integers get their sign bit flipped, so negative values end up in front of the positive ones
+	 * - floating point values flip the sign bit of positive and all bits of negative values (-0.0f sorts before 0.0f,
+	 *   NaNs with the sign bit set go first and all others last)
+	 */
+	template <size_t Size> struct UnsignedOfSize;
+	template <> struct UnsignedOfSize<1> { typedef uint8_t Type; };
+	template <> struct UnsignedOfSize<2> { typedef uint16_t Type; };
+	template <> struct UnsignedOfSize<4> { typedef uint32_t Type; };
+	template <> struct UnsignedOfSize<8> { typedef uint64_t Type; };
+
+	template <typename T, bool IsFloatingPoint = std::is_floating_point<T>::value, bool IsSigned = std::is_signed<T>::value>
+	struct RadixKey
+	{
+		typedef typename UnsignedOfSize<sizeof(T)>::Type KeyType;
+		static KeyType ToKey(T value) { return static_cast<KeyType>(value); }
+	};
+
+	template <typename T>
+	struct RadixKey<T, false, true>
+	{
+		typedef typename UnsignedOfSize<sizeof(T)>::Type KeyType;
+		static KeyType ToKey(T value)
+		{
+			return static_cast<KeyType>(static_cast<KeyType>(value) ^ (KeyType(1) << (sizeof(T) * 8u - 1u)));
+		}
+	};
+
+	template <typename T, bool IsSigned>
+	struct RadixKey<T, true, IsSigned>
+	{
+		typedef typename UnsignedOfSize<sizeof(T)>::Type KeyType;
+		static KeyType ToKey(T value)
+		{
+			KeyType bits;
+			std::memcpy(&bits, &value, sizeof(T));
+			const KeyType signBit = KeyType(1) << (sizeof(T) * 8u - 1u);
+			return (bits & signBit) ? static_cast<KeyType>(~bits) : static_cast<KeyType>(bits | signBit);
+		}
+	};
+
+	/**
+	 * Allocates the scratch array of a sort as its own Vector reservation. Types that can live in uninitialized memory
+	 * don't pay for constructing it, all others get copies of the elements (the merges assign into them)
+	 */
+	template <typename T>
+	void PrepareScratch(Vector<T>& scratch, const Vector<T>& vector, std::true_type)
+	{
+		scratch.resize_uninitialized(vector.size());
+	}
+
+	template <typename T>
+	void PrepareScratch(Vector<T>& scratch, const Vector<T>& vector, std::false_type)
+	{
+		scratch = vector;
+	}
+
+	template <typename T>
+	void PrepareScratch(Vector<T>& scratch, const Vector<T>& vector)
+	{
+		PrepareScratch(scratch, vector, std::integral_constant<bool, std::is_trivially_default_constructible<T>::value && std::is_trivially_destructible<T>::value>());
+	}
+
+	/**
+	 * Returns how many of the first k elements of the merge of a and b come from a (the co-rank of k). std::merge takes
+	 * the element of a on ties, the split keeps that order, so merging the pieces left and right of a split gives exactly
+	 * the result of one big std::merge
+	 */
+	template <typename T, typename Compare>
+	size_t MergeSplit(const T* a, size_t aCount, const T* b, size_t bCount, size_t k, Compare& compare)
+	{
+		size_t low = k > bCount ? k - bCount : 0u;
+		size_t high = k < aCount ? k : aCount;
+		while (low < high)
+		{
+			const size_t i = (low + high) / 2u;
+			const size_t j = k - i;
+			// If b[j - 1] would not be taken before a[i] we took too much from b
+			if (j > 0u && i < aCount && !compare(b[j - 1u], a[i]))
+			{
+				low = i + 1u;
+			}
+			else
+			{
+				high = i;
+			}
+		}
+		return low;
+	}
+}
+
+/**
+ * radix_sort sorts a vector of integers or floating point values in ascending order with a parallel LSD radix sort.
+ * Every pass looks at one byte of the keys (see Sorting::RadixKey):
+ * - Each block of the vector builds its own histogram in parallel
+ * - A prefix sum over (byte value, block) gives every block the target offsets of its elements, which keeps the sort stable
+ * - Each block scatters its elements to the scratch array in parallel, the arrays swap roles for the next pass
+ * Passes where all keys share the same byte are skipped. The scratch array is a sibling Vector reservation
+ */
+template <typename T>
+void radix_sort(Vector<T>& vector)
+{
+	static_assert((std::is_integral<T>::value || std::is_floating_point<T>::value) && sizeof(T) <= 8u, "radix_sort requires an integral or floating point type of up to 8 bytes");
+	typedef Sorting::RadixKey<T> Key;
+
+	const size_t count = vector.size();
+	if (count < 256u)
+	{
+		std::sort(vector.begin(), vector.end());
+		return;
+	}
+
+	Vector<T> scratch;
+	scratch.resize_uninitialized(count);
+
+	// One block per thread keeps the histograms small, but blocks are never smaller than 64K elements
+	const size_t threadCount = Parallel::ThreadPool::Instance().GetThreadCount();
+	size_t blockSize = (count + threadCount - 1u) / threadCount;
+	blockSize = blockSize > 65536u ? blockSize : 65536u;
+	const size_t blockCount = (count + blockSize - 1u) / blockSize;
+
+	Vector<size_t> offsets;
+	offsets.resize_uninitialized(blockCount * 256u);
+	size_t* const blockOffsets = offsets.data();
+
+	T* source = vector.data();
+	T* target = scratch.data();
+	for (size_t shift = 0u; shift < sizeof(T) * 8u; shift += 8u)
+	{
+		Parallel::ForEachRange(count, blockSize, [source, blockOffsets, shift](size_t block, size_t rangeBegin, size_t rangeEnd)
+		{
+			size_t* const histogram = blockOffsets + block * 256u;
+			std::fill(histogram, histogram + 256u, size_t(0u));
+			for (size_t i = rangeBegin; i < rangeEnd; ++i)
+			{
+				++histogram[(Key::ToKey(source[i]) >> shift) & 0xFFu];
+			}
+		});
+
+		// Turn the counts into target offsets: all elements of byte value 0 (block by block) first, then byte value 1 ...
+		size_t offset = 0u;
+		bool isPassNeeded = true;
+		for (size_t digit = 0u; digit < 256u; ++digit)
+		{
+			size_t digitCount = 0u;
+			for (size_t block = 0u; block < blockCount; ++block)
+			{
+				const size_t blockDigitCount = blockOffsets[block * 256u + digit];
+				blockOffsets[block * 256u + digit] = offset;
+				offset += blockDigitCount;
+				digitCount += blockDigitCount;
+			}
+			if (digitCount == count)
+			{
+				isPassNeeded = false;
+				break;
+			}
+		}
+
+		if (!isPassNeeded)
+		{
+			continue;
+		}
+
+		Parallel::ForEachRange(count, blockSize, [source, target, blockOffsets, shift](size_t block, size_t rangeBegin, size_t rangeEnd)
+		{
+			size_t* const blockOffset = blockOffsets + block * 256u;
+			for (size_t i = rangeBegin; i < rangeEnd; ++i)
+			{
+				target[blockOffset[(Key::ToKey(source[i]) >> shift) & 0xFFu]++] = source[i];
+			}
+		});
+		std::swap(source, target);
+	}
+
+	if (source != vector.data())
+	{
+		T* const result = vector.data();
+		Parallel::ForEachRange(count, blockSize, [source, result](size_t, size_t rangeBegin, size_t rangeEnd)
+		{
+			std::memcpy(result + rangeBegin, source + rangeBegin, (rangeEnd - rangeBegin) * sizeof(T));
+		});
+	}
+}
+
+/**
+ * parallel_sort sorts any vector with the given comparator (a strict weak ordering like for std::sort, not stable):
+ * - The vector is split into one run per thread, every run is sorted with std::sort in parallel
+ * - Runs are merged pairwise until one run is left. Every merge round splits its output into equally sized pieces
+ *   (see Sorting::MergeSplit), so even the last round with a single merge keeps all threads busy
+ * The merges ping-pong between the vector and a scratch copy in a sibling reservation. T needs the CCTOR and
+ * assignment OP, and both have to be safe to call from several threads at once
+ */
+template <typename T, typename Compare>
+void parallel_sort(Vector<T>& vector, Compare compare)
+{
+	const size_t count = vector.size();
+	const size_t threadCount = Parallel::ThreadPool::Instance().GetThreadCount();
+	size_t runSize = (count + threadCount - 1u) / threadCount;
+	runSize = runSize > 16384u ? runSize : 16384u;
+	if (count <= runSize)
+	{
+		std::sort(vector.begin(), vector.end(), compare);
+		return;
+	}
+
+	T* const elements = vector.data();
+	Parallel::ForEachRange(count, runSize, [elements, &compare](size_t, size_t rangeBegin, size_t rangeEnd)
+	{
+		std::sort(elements + rangeBegin, elements + rangeEnd, compare);
+	});
+
+	Vector<T> scratch;
+	Sorting::PrepareScratch(scratch, vector);
+
+	const size_t pieceSize = runSize / 2u;
+	T* source = elements;
+	T* target = scratch.data();
+	for (size_t width = runSize; width < count; width *= 2u)
+	{
+		// A piece of the output may cover several small merges (early rounds) or a part of one big merge (late rounds)
+		Parallel::ForEachRange(count, pieceSize, [source, target, width, count, &compare](size_t, size_t pieceBegin, size_t pieceEnd)
+		{
+			for (size_t mergeBegin = pieceBegin / (2u * width) * (2u * width); mergeBegin < pieceEnd; mergeBegin += 2u * width)
+			{
+				const size_t middle = mergeBegin + width < count ? mergeBegin + width : count;
+				const size_t mergeEnd = mergeBegin + 2u * width < count ? mergeBegin + 2u * width : count;
+				const T* const a = source + mergeBegin;
+				const T* const b = source + middle;
+				const size_t aCount = middle - mergeBegin;
+				const size_t bCount = mergeEnd - middle;
+
+				const size_t outputBegin = (pieceBegin > mergeBegin ? pieceBegin : mergeBegin) - mergeBegin;
+				const size_t outputEnd = (pieceEnd < mergeEnd ? pieceEnd : mergeEnd) - mergeBegin;
+				const size_t aBegin = Sorting::MergeSplit(a, aCount, b, bCount, outputBegin, compare);
+				const size_t aEnd = Sorting::MergeSplit(a, aCount, b, bCount, outputEnd, compare);
+
+				std::merge(a + aBegin, a + aEnd, b + (outputBegin - aBegin), b + (outputEnd - aEnd), target + mergeBegin + outputBegin, compare);
+			}
+		});
+		std::swap(source, target);
+	}
+
+	if (source != elements)
+	{
+		Parallel::ForEachRange(count, pieceSize, [source, elements](size_t, size_t rangeBegin, size_t rangeEnd)
+		{
+			std::copy(source + rangeBegin, source + rangeEnd, elements + rangeBegin);
+		});
+	}
+}
+
+template <typename T>
+void parallel_sort(Vector<T>& vector)
+{
+	parallel_sort(vector, std::less<T>());
+}
+
+// Instruction sets whose kernels get compiled, see the Simd namespace below
+#if defined(_MSC_VER) || defined(__AVX2__)
+#define SIMD_AVX2_KERNELS 1
+#else
+#define SIMD_AVX2_KERNELS 0
+#endif
+
+#if defined(_MSC_VER) || defined(__AVX512F__)
+#define SIMD_AVX512_KERNELS 1
+#else
+#define SIMD_AVX512_KERNELS 0
+#endif
+
+/**
+ * Simd namespace holds the vectorized kernels behind simd_sum, simd_min, simd_max, simd_count_if_equal, simd_find
+ * and simd_any_of. Every instruction set provides an Ops<T> struct for 32 and 64 bit integers, float and double
+ * (one register, its lane count and the handful of operations the kernels need), the kernels are written once
+ * against that interface. The best instruction set the CPU and OS support is picked at runtime.
+ * MSVC compiles all instruction sets into every build. GCC and clang only allow AVX intrinsics in code compiled
+ * for AVX, there the AVX2 / AVX-512 kernels are only built if the compiler flags enable them (e.g. -mavx2)
+ */
+namespace Simd
+{
+	enum class InstructionSet
+	{
+		Sse2,
+		Avx2,
+		Avx512
+	};
+
+	/**
+	 * Queries the CPU features and which register states the OS saves on context switches (XCR0), AVX registers
+	 * must not be used if the OS doesn't preserve them
+	 */
+	InstructionSet DetectInstructionSet(void)
+	{
+		int info[4] = {};
+		uint64_t enabledStates = 0u;
+#if defined(_MSC_VER)
+		__cpuidex(info, 0, 0);
+		const int maxLeaf = info[0];
+		__cpuidex(info, 1, 0);
+		const bool hasAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+		if (hasAvx)
+		{
+			enabledStates = _xgetbv(0);
+		}
+		__cpuidex(info, 7, 0);
+#else
+		unsigned int registers[4] = {};
+		__cpuid_count(0, 0, registers[0], registers[1], registers[2], registers[3]);
+		const int maxLeaf = static_cast<int>(registers[0]);
+		__cpuid_count(1, 0, registers[0], registers[1], registers[2], registers[3]);
+		const bool hasAvx = (registers[2] & (1u << 27)) != 0u && (registers[2] & (1u << 28)) != 0u;
+		if (hasAvx)
+		{
+			unsigned int low;
+			unsigned int high;
+			__asm__ __volatile__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+			enabledStates = (static_cast<uint64_t>(high) << 32) | low;
+		}
+		__cpuid_count(7, 0, registers[0], registers[1], registers[2], registers[3]);
+		std::memcpy(info, registers, sizeof(info));
+#endif
+		if (maxLeaf < 7 || !hasAvx)
+		{
+			return InstructionSet::Sse2;
+		}
+
+		// XMM / YMM state for AVX, additionally the opmask and both ZMM parts for AVX-512
+		const bool isAvxEnabled = (enabledStates & 0x6u) == 0x6u;
+		const bool isAvx512Enabled = (enabledStates & 0xE6u) == 0xE6u;
+		const bool hasAvx2 = (info[1] & (1 << 5)) != 0;
+		const bool hasAvx512 = (info[1] & (1 << 16)) != 0;
+
+		if (SIMD_AVX512_KERNELS && hasAvx512 && isAvx512Enabled)
+		{
+			return InstructionSet::Avx512;
+		}
+		if (SIMD_AVX2_KERNELS && hasAvx2 && isAvxEnabled)
+		{
+			return InstructionSet::Avx2;
+		}
+		return InstructionSet::Sse2;
+	}
+
+	InstructionSet GetInstructionSet(void)
+	{
+		static const InstructionSet instructionSet = DetectInstructionSet();
+		return instructionSet;
+	}
+
+	/**
+	 * The kernels work on the fixed width integer with the same size and signedness (e.g. long on Windows runs the
+	 * int32_t kernels), float and double are their own kernel type
+	 */
+	template <typename T, bool IsFloatingPoint = std::is_floating_point<T>::value>
+	struct KernelType
+	{
+		static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value && (sizeof(T) == 4u || sizeof(T) == 8u), "The SIMD kernels support 32 / 64 bit integers, float and double");
+		typedef typename std::conditional<sizeof(T) == 4u,
+			typename std::conditional<std::is_signed<T>::value, int32_t, uint32_t>::type,
+			typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type>::type Type;
+	};
+
+	template <typename T>
+	struct KernelType<T, true>
+	{
+		static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "The SIMD kernels support 32 / 64 bit integers, float and double");
+		typedef T Type;
+	};
+
+	size_t CountBits(uint64_t bits)
+	{
+		bits = bits - ((bits >> 1) & 0x5555555555555555ull);
+		bits = (bits & 0x3333333333333333ull) + ((bits >> 2) & 0x3333333333333333ull);
+		bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return static_cast<size_t>((bits * 0x0101010101010101ull) >> 56);
+	}
+
+	size_t LowestSetBit(uint64_t bits)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return index;
+#else
+		return static_cast<size_t>(__builtin_ctzll(bits));
+#endif
+	}
+
+	namespace Sse2
+	{
+		inline __m128i Select(__m128i mask, __m128i ifSet, __m128i ifClear)
+		{
+			return _mm_or_si128(_mm_and_si128(mask, ifSet), _mm_andnot_si128(mask, ifClear));
+		}
+
+		template <typename T>
+		struct Integer32Ops
+		{
+			typedef T Element;
+			typedef __m128i Register;
+			static const size_t LANES = 4;
+
+			static Register Load(const T* source) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)); }
+			static void Store(T* target, Register value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(target), value); }
+			static Register Broadcast(T value) { return _mm_set1_epi32(static_cast<int>(value)); }
+			static Register Zero(void) { return _mm_setzero_si128(); }
+			static Register Add(Register a, Register b) { return _mm_add_epi32(a, b); }
+			static Register Greater(Register a, Register b)
+			{
+				if (std::is_signed<T>::value)
+				{
+					return _mm_cmpgt_epi32(a, b);
+				}
+				const __m128i bias = _mm_set1_epi32(static_cast<int>(0x80000000u));
+				return _mm_cmpgt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+			}
+			static Register Min(Register a, Register b) { return Select(Greater(a, b), b, a); }
+			static Register Max(Register a, Register b) { return Select(Greater(a, b), a, b); }
+			static uint32_t EqualMask(Register a, Register b) { return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)))); }
+		};
+
+		/**
+		 * SSE2 has no 64 bit compares, they are put together from the 32 bit halves
+		 */
+		template <typename T>
+		struct Integer64Ops
+		{
+			typedef T Element;
+			typedef __m128i Register;
+			static const size_t LANES = 2;
+
+			static Register Load(const T* source) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)); }
+			static void Store(T* target, Register value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(target), value); }
+			static Register Broadcast(T value) { return _mm_set1_epi64x(static_cast<long long>(value)); }
+			static Register Zero(void) { return _mm_setzero_si128(); }
+			static Register Add(Register a, Register b) { return _mm_add_epi64(a, b); }
+			static Register Greater(Register a, Register b)
+			{
+				if (!std::is_signed<T>::value)
+				{
+					const __m128i bias = _mm_set1_epi64x(static_cast<long long>(0x8000000000000000ull));
+					a = _mm_xor_si128(a, bias);
+					b = _mm_xor_si128(b, bias);
+				}
+				// Signed compare of the high halves, on equal high halves an unsigned compare of the low halves decides
+				const __m128i lowBias = _mm_set1_epi32(static_cast<int>(0x80000000u));
+				const __m128i highGreater = _mm_cmpgt_epi32(a, b);
+				const __m128i highEqual = _mm_cmpeq_epi32(a, b);
+				const __m128i lowGreater = _mm_cmpgt_epi32(_mm_xor_si128(a, lowBias), _mm_xor_si128(b, lowBias));
+				return _mm_or_si128(_mm_shuffle_epi32(highGreater, _MM_SHUFFLE(3, 3, 1, 1)),
+					_mm_and_si128(_mm_shuffle_epi32(highEqual, _MM_SHUFFLE(3, 3, 1, 1)), _mm_shuffle_epi32(lowGreater, _MM_SHUFFLE(2, 2, 0, 0))));
+			}
+			static Register Min(Register a, Register b) { return Select(Greater(a, b), b, a); }
+			static Register Max(Register a, Register b) { return Select(Greater(a, b), a, b); }
+			static uint32_t EqualMask(Register a, Register b)
+			{
+				const __m128i halvesEqual = _mm_cmpeq_epi32(a, b);
+				const __m128i equal = _mm_and_si128(halvesEqual, _mm_shuffle_epi32(halvesEqual, _MM_SHUFFLE(2, 3, 0, 1)));
+				return static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(equal)));
+			}
+		};
+
+		template <typename T> struct Ops;
+		template <> struct Ops<int32_t> : Integer32Ops<int32_t> {};
+		template <> struct Ops<uint32_t> : Integer32Ops<uint32_t> {};
+		template <> struct Ops<int64_t> : Integer64Ops<int64_t> {};
+		template <> struct Ops<uint64_t> : Integer64Ops<uint64_t> {};
+
+		template <>
+		struct Ops<float>
+		{
+			typedef float Element;
+			typedef __m128 Register;
+			static const size_t LANES = 4;
+
+			static Register Load(const float* source) { return _mm_loadu_ps(source); }
+			static void Store(float* target, Register value) { _mm_storeu_ps(target, value); }
+			static Register Broadcast(float value) { return _mm_set1_ps(value); }
+			static Register Zero(void) { return _mm_setzero_ps(); }
+			static Register Add(Register a, Register b) { return _mm_add_ps(a, b); }
+			static Register Sub(Register a, Register b) { return _mm_sub_ps(a, b); }
+			static Register Mul(Register a, Register b) { return _mm_mul_ps(a, b); }
+			static Register Div(Register a, Register b) { return _mm_div_ps(a, b); }
+			static Register Min(Register a, Register b) { return _mm_min_ps(a, b); }
+			static Register Max(Register a, Register b) { return _mm_max_ps(a, b); }
+			static uint32_t EqualMask(Register a, Register b) { return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmpeq_ps(a, b))); }
+		};
+
+		template <>
+		struct Ops<double>
+		{
+			typedef double Element;
+			typedef __m128d Register;
+			static const size_t LANES = 2;
+
+			static Register Load(const double* source) { return _mm_loadu_pd(source); }
+			static void Store(double* target, Register value) { _mm_storeu_pd(target, value); }
+			static Register Broadcast(double value) { return _mm_set1_pd(value); }
+			static Register Zero(void) { return _mm_setzero_pd(); }
+			static Register Add(Register a, Register b) { return _mm_add_pd(a, b); }
+			static Register Sub(Register a, Register b) { return _mm_sub_pd(a, b); }
+			static Register Mul(Register a, Register b) { return _mm_mul_pd(a, b); }
+			static Register Div(Register a, Register b) { return _mm_div_pd(a, b); }
+			static Register Min(Register a, Register b) { return _mm_min_pd(a, b); }
+			static Register Max(Register a, Register b) { return _mm_max_pd(a, b); }
+			static uint32_t EqualMask(Register a, Register b) { return static_cast<uint32_t>(_mm_movemask_pd(_mm_cmpeq_pd(a, b))); }
+		};
+
+		/**
+		 * Returns the offset of the first byte that differs or byteCount. A whole cache line is compared per
+		 * iteration and only a differing line is searched for the exact byte
+		 */
+		inline size_t FirstDifferentByte(const uint8_t* left, const uint8_t* right, size_t byteCount)
+		{
+			size_t i = 0u;
+			for (; i + 64u <= byteCount; i += 64u)
+			{
+				const __m128i equal0 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i)));
+				const __m128i equal1 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i + 16u)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i + 16u)));
+				const __m128i equal2 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i + 32u)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i + 32u)));
+				const __m128i equal3 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i + 48u)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i + 48u)));
+				if (_mm_movemask_epi8(_mm_and_si128(_mm_and_si128(equal0, equal1), _mm_and_si128(equal2, equal3))) != 0xFFFF)
+				{
+					const uint64_t equal = static_cast<uint64_t>(_mm_movemask_epi8(equal0))
+						| (static_cast<uint64_t>(_mm_movemask_epi8(equal1)) << 16)
+						| (static_cast<uint64_t>(_mm_movemask_epi8(equal2)) << 32)
+						| (static_cast<uint64_t>(_mm_movemask_epi8(equal3)) << 48);
+					return i + LowestSetBit(~equal);
+				}
+			}
+			for (; i + 16u <= byteCount; i += 16u)
+			{
+				const uint32_t equal = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i)))));
+				if (equal != 0xFFFFu)
+				{
+					return i + LowestSetBit(~equal & 0xFFFFu);
+				}
+			}
+			for (; i < byteCount; ++i)
+			{
+				if (left[i] != right[i])
+				{
+					return i;
+				}
+			}
+			return byteCount;
+		}
+	}
+
+#if SIMD_AVX2_KERNELS
+	namespace Avx2
+	{
+		template <typename T>
+		struct Integer32Ops
+		{
+			typedef T Element;
+			typedef __m256i Register;
+			static const size_t LANES = 8;
+
+			static Register Load(const T* source) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source)); }
+			static void Store(T* target, Register value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(target), value); }
+			static Register Broadcast(T value) { return _mm256_set1_epi32(static_cast<int>(value)); }
+			static Register Zero(void) { return _mm256_setzero_si256(); }
+			static Register Add(Register a, Register b) { return _mm256_add_epi32(a, b); }
+			static Register Min(Register a, Register b) { return std::is_signed<T>::value ? _mm256_min_epi32(a, b) : _mm256_min_epu32(a, b); }
+			static Register Max(Register a, Register b) { return std::is_signed<T>::value ? _mm256_max_epi32(a, b) : _mm256_max_epu32(a, b); }
+			static uint32_t EqualMask(Register a, Register b) { return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)))); }
+		};
+
+		template <typename T>
+		struct Integer64Ops
+		{
+			typedef T Element;
+			typedef __m256i Register;
+			static const size_t LANES = 4;
+
+			static Register Load(const T* source) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source)); }
+			static void Store(T* target, Register value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(target), value); }
+			static Register Broadcast(T value) { return _mm256_set1_epi64x(static_cast<long long>(value)); }
+			static Register Zero(void) { return _mm256_setzero_si256(); }
+			static Register Add(Register a, Register b) { return _mm256_add_epi64(a, b); }
+			static Register Greater(Register a, Register b)
+			{
+				if (std::is_signed<T>::value)
+				{
+					return _mm256_cmpgt_epi64(a, b);
+				}
+				const __m256i bias = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ull));
+				return _mm256_cmpgt_epi64(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias));
+			}
+			static Register Min(Register a, Register b) { return _mm256_blendv_epi8(a, b, Greater(a, b)); }
+			static Register Max(Register a, Register b) { return _mm256_blendv_epi8(b, a, Greater(a, b)); }
+			static uint32_t EqualMask(Register a, Register b) { return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b)))); }
+		};
+
+		template <typename T> struct Ops;
+		template <> struct Ops<int32_t> : Integer32Ops<int32_t> {};
+		template <> struct Ops<uint32_t> : Integer32Ops<uint32_t> {};
+		template <> struct Ops<int64_t> : Integer64Ops<int64_t> {};
+		template <> struct Ops<uint64_t> : Integer64Ops<uint64_t> {};
+
+		template <>
+		struct Ops<float>
+		{
+			typedef float Element;
+			typedef __m256 Register;
+			static const size_t LANES = 8;
+
+			static Register Load(const float* source) { return _mm256_loadu_ps(source); }
+			static void Store(float* target, Register value) { _mm256_storeu_ps(target, value); }
+			static Register Broadcast(float value) { return _mm256_set1_ps(value); }
+			static Register Zero(void) { return _mm256_setzero_ps(); }
+			static Register Add(Register a, Register b) { return _mm256_add_ps(a, b); }
+			static Register Sub(Register a, Register b) { return _mm256_sub_ps(a, b); }
+			static Register Mul(Register a, Register b) { return _mm256_mul_ps(a, b); }
+			static Register Div(Register a, Register b) { return _mm256_div_ps(a, b); }
+			static Register Min(Register a, Register b) { return _mm256_min_ps(a, b); }
+			static Register Max(Register a, Register b) { return _mm256_max_ps(a, b); }
+			static uint32_t EqualMask(Register a, Register b) { return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ))); }
+		};
+
+		template <>
+		struct Ops<double>
+		{
+			typedef double Element;
+			typedef __m256d Register;
+			static const size_t LANES = 4;
+
+			static Register Load(const double* source) { return _mm256_loadu_pd(source); }
+			static void Store(double* target, Register value) { _mm256_storeu_pd(target, value); }
+			static Register Broadcast(double value) { return _mm256_set1_pd(value); }
+			static Register Zero(void) { return _mm256_setzero_pd(); }
+			static Register Add(Register a, Register b) { return _mm256_add_pd(a, b); }
+			static Register Sub(Register a, Register b) { return _mm256_sub_pd(a, b); }
+			static Register Mul(Register a, Register b) { return _mm256_mul_pd(a, b); }
+			static Register Div(Register a, Register b) { return _mm256_div_pd(a, b); }
+			static Register Min(Register a, Register b) { return _mm256_min_pd(a, b); }
+			static Register Max(Register a, Register b) { return _mm256_max_pd(a, b); }
+			static uint32_t EqualMask(Register a, Register b) { return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ))); }
+		};
+
+		inline size_t FirstDifferentByte(const uint8_t* left, const uint8_t* right, size_t byteCount)
+		{
+			size_t i = 0u;
+			for (; i + 64u <= byteCount; i += 64u)
+			{
+				const __m256i equal0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i)));
+				const __m256i equal1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i + 32u)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i + 32u)));
+				if (_mm256_movemask_epi8(_mm256_and_si256(equal0, equal1)) != -1)
+				{
+					const uint64_t equal = static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(equal0)))
+						| (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(equal1))) << 32);
+					_mm256_zeroupper();
+					return i + LowestSetBit(~equal);
+				}
+			}
+			_mm256_zeroupper();
+			return i + Sse2::FirstDifferentByte(left + i, right + i, byteCount - i);
+		}
+	}
+#endif
+
+#if SIMD_AVX512_KERNELS
+	namespace Avx512
+	{
+		template <typename T>
+		struct Integer32Ops
+		{
+			typedef T Element;
+			typedef __m512i Register;
+			static const size_t LANES = 16;
+
+			static Register Load(const T* source) { return _mm512_loadu_si512(source); }
+			static void Store(T* target, Register value) { _mm512_storeu_si512(target, value); }
+			static Register Broadcast(T value) { return _mm512_set1_epi32(static_cast<int>(value)); }
+			static Register Zero(void) { return _mm512_setzero_si512(); }
+			static Register Add(Register a, Register b) { return _mm512_add_epi32(a, b); }
+			static Register Min(Register a, Register b) { return std::is_signed<T>::value ? _mm512_min_epi32(a, b) : _mm512_min_epu32(a, b); }
+			static Register Max(Register a, Register b) { return std::is_signed<T>::value ? _mm512_max_epi32(a, b) : _mm512_max_epu32(a, b); }
+			static uint32_t EqualMask(Register a, Register b) { return static_cast<uint32_t>(_mm512_cmpeq_epi32_mask(a, b)); }
+		};
+
+		template <typename T>
+		struct Integer64Ops
+		{
+			typedef T Element;
+			typedef __m512i Register;
+			static const size_t LANES = 8;
+
+			static Register Load(const T* source) { return _mm512_loadu_si512(source); }
+			static void Store(T* target, Register value) { _mm512_storeu_si512(target, value); }
+			static Register Broadcast(T value) { return _mm512_set1_epi64(static_cast<long long>(value)); }
+			static Register Zero(void) { return _mm512_setzero_si512(); }
+			static Register Add(Register a, Register b) { return _mm512_add_epi64(a, b); }
+			static Register Min(Register a, Register b) { return std::is_signed<T>::value ? _mm512_min_epi64(a, b) : _mm512_min_epu64(a, b); }
+			static Register Max(Register a, Register b) { return std::is_signed<T>::value ? _mm512_max_epi64(a, b) : _mm512_max_epu64(a, b); }
+			static uint32_t EqualMask(Register a, Register b) { return static_cast<uint32_t>(_mm512_cmpeq_epi64_mask(a, b)); }
+		};
+
+		template <typename T> struct Ops;
+		template <> struct Ops<int32_t> : Integer32Ops<int32_t> {};
+		template <> struct Ops<uint32_t> : Integer32Ops<uint32_t> {};
+		template <> struct Ops<int64_t> : Integer64Ops<int64_t> {};
+		template <> struct Ops<uint64_t> : Integer64Ops<uint64_t> {};
+
+		template <>
+		struct Ops<float>
+		{
+			typedef float Element;
+			typedef __m512 Register;
+			static const size_t LANES = 16;
+
+			static Register Load(const float* source) { return _mm512_loadu_ps(source); }
+			static void Store(float* target, Register value) { _mm512_storeu_ps(target, value); }
+			static Register Broadcast(float value) { return _mm512_set1_ps(value); }
+			static Register Zero(void) { return _mm512_setzero_ps(); }
+			static Register Add(Register a, Register b) { return _mm512_add_ps(a, b); }
+			static Register Sub(Register a, Register b) { return _mm512_sub_ps(a, b); }
+			static Register Mul(Register a, Register b) { return _mm512_mul_ps(a, b); }
+			static Register Div(Register a, Register b) { return _mm512_div_ps(a, b); }
+			static Register Min(Register a, Register b) { return _mm512_min_ps(a, b); }
+			static Register Max(Register a, Register b) { return _mm512_max_ps(a, b); }
+			static uint32_t EqualMask(Register a, Register b) { return static_cast<uint32_t>(_mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ)); }
+		};
+
+		template <>
+		struct Ops<double>
+		{
+			typedef double Element;
+			typedef __m512d Register;
+			static const size_t LANES = 8;
+
+			static Register Load(const double* source) { return _mm512_loadu_pd(source); }
+			static void Store(double* target, Register value) { _mm512_storeu_pd(target, value); }
+			static Register Broadcast(double value) { return _mm512_set1_pd(value); }
+			static Register Zero(void) { return _mm512_setzero_pd(); }
+			static Register Add(Register a, Register b) { return _mm512_add_pd(a, b); }
+			static Register Sub(Register a, Register b) { return _mm512_sub_pd(a, b); }
+			static Register Mul(Register a, Register b) { return _mm512_mul_pd(a, b); }
+			static Register Div(Register a, Register b) { return _mm512_div_pd(a, b); }
+			static Register Min(Register a, Register b) { return _mm512_min_pd(a, b); }
+			static Register Max(Register a, Register b) { return _mm512_max_pd(a, b); }
+			static uint32_t EqualMask(Register a, Register b) { return static_cast<uint32_t>(_mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ)); }
+		};
+	}
+#endif
+
+	/**
+	 * Sums up the elements in four independent accumulators, so the adds of one iteration don't wait for each other.
+	 * Integers wrap around like in a scalar loop, float sums are rounded in a different order than a scalar loop would
+	 */
+	template <typename Ops>
+	struct SumKernel
+	{
+		typedef typename Ops::Element T;
+
+		static T Run(const T* elements, size_t count)
+		{
+			const size_t lanes = Ops::LANES;
+			typename Ops::Register sum0 = Ops::Zero();
+			typename Ops::Register sum1 = Ops::Zero();
+			typename Ops::Register sum2 = Ops::Zero();
+			typename Ops::Register sum3 = Ops::Zero();
+
+			size_t i = 0u;
+			for (; i + 4u * lanes <= count; i += 4u * lanes)
+			{
+				sum0 = Ops::Add(sum0, Ops::Load(elements + i));
+				sum1 = Ops::Add(sum1, Ops::Load(elements + i + lanes));
+				sum2 = Ops::Add(sum2, Ops::Load(elements + i + 2u * lanes));
+				sum3 = Ops::Add(sum3, Ops::Load(elements + i + 3u * lanes));
+			}
+			for (; i + lanes <= count; i += lanes)
+			{
+				sum0 = Ops::Add(sum0, Ops::Load(elements + i));
+			}
+
+			T laneSums[Ops::LANES];
+			Ops::Store(laneSums, Ops::Add(Ops::Add(sum0, sum1), Ops::Add(sum2, sum3)));
+			T sum = T(0);
+			for (size_t lane = 0u; lane < lanes; ++lane)
+			{
+				sum += laneSums[lane];
+			}
+			for (; i < count; ++i)
+			{
+				sum += elements[i];
+			}
+			return sum;
+		}
+	};
+
+	/**
+	 * Min and max need at least one element. Min / max don't care about elements seen twice, so the remainder is
+	 * handled with one last load that overlaps the previous ones instead of a scalar loop
+	 */
+	template <typename Ops, bool IsMin>
+	struct MinMaxKernel
+	{
+		typedef typename Ops::Element T;
+
+		static typename Ops::Register Pick(typename Ops::Register a, typename Ops::Register b)
+		{
+			return IsMin ? Ops::Min(a, b) : Ops::Max(a, b);
+		}
+
+		static T Run(const T* elements, size_t count)
+		{
+			const size_t lanes = Ops::LANES;
+			T result = elements[0];
+			if (count < lanes)
+			{
+				for (size_t i = 1u; i < count; ++i)
+				{
+					result = (IsMin ? elements[i] < result : result < elements[i]) ? elements[i] : result;
+				}
+				return result;
+			}
+
+			typename Ops::Register pick0 = Ops::Load(elements);
+			typename Ops::Register pick1 = pick0;
+			typename Ops::Register pick2 = pick0;
+			typename Ops::Register pick3 = pick0;
+
+			size_t i = lanes;
+			for (; i + 4u * lanes <= count; i += 4u * lanes)
+			{
+				pick0 = Pick(pick0, Ops::Load(elements + i));
+				pick1 = Pick(pick1, Ops::Load(elements + i + lanes));
+				pick2 = Pick(pick2, Ops::Load(elements + i + 2u * lanes));
+				pick3 = Pick(pick3, Ops::Load(elements + i + 3u * lanes));
+			}
+			for (; i + lanes <= count; i += lanes)
+			{
+				pick0 = Pick(pick0, Ops::Load(elements + i));
+			}
+			pick0 = Pick(pick0, Ops::Load(elements + count - lanes));
+
+			T lanePicks[Ops::LANES];
+			Ops::Store(lanePicks, Pick(Pick(pick0, pick1), Pick(pick2, pick3)));
+			for (size_t lane = 0u; lane < lanes; ++lane)
+			{
+				result = (IsMin ? lanePicks[lane] < result : result < lanePicks[lane]) ? lanePicks[lane] : result;
+			}
+			return result;
+		}
+	};
+
+	template <typename Ops>
+	using MinKernel = MinMaxKernel<Ops, true>;
+
+	template <typename Ops>
+	using MaxKernel = MinMaxKernel<Ops, false>;
+
+	/**
+	 * Compares four registers per iteration and packs their lane masks into one 64 bit word (16 lanes at most),
+	 * so a single population count / bit scan covers all of them
+	 */
+	template <typename Ops>
+	struct CountEqualKernel
+	{
+		typedef typename Ops::Element T;
+
+		static size_t Run(const T* elements, size_t count, T value)
+		{
+			const size_t lanes = Ops::LANES;
+			const typename Ops::Register key = Ops::Broadcast(value);
+			size_t matches = 0u;
+
+			size_t i = 0u;
+			for (; i + 4u * lanes <= count; i += 4u * lanes)
+			{
+				const uint64_t mask = static_cast<uint64_t>(Ops::EqualMask(Ops::Load(elements + i), key))
+					| (static_cast<uint64_t>(Ops::EqualMask(Ops::Load(elements + i + lanes), key)) << lanes)
+					| (static_cast<uint64_t>(Ops::EqualMask(Ops::Load(elements + i + 2u * lanes), key)) << (2u * lanes))
+					| (static_cast<uint64_t>(Ops::EqualMask(Ops::Load(elements + i + 3u * lanes), key)) << (3u * lanes));
+				matches += CountBits(mask);
+			}
+			for (; i + lanes <= count; i += lanes)
+			{
+				matches += CountBits(Ops::EqualMask(Ops::Load(elements + i), key));
+			}
+			for (; i < count; ++i)
+			{
+				matches += elements[i] == value ? 1u : 0u;
+			}
+			return matches;
+		}
+	};
+
+	/**
+	 * Returns the index of the first element equal to value or count if there is none
+	 */
+	template <typename Ops>
+	struct FindEqualKernel
+	{
+		typedef typename Ops::Element T;
+
+		static size_t Run(const T* elements, size_t count, T value)
+		{
+			const size_t lanes = Ops::LANES;
+			const typename Ops::Register key = Ops::Broadcast(value);
+
+			size_t i = 0u;
+			for (; i + 4u * lanes <= count; i += 4u * lanes)
+			{
+				const uint64_t mask = static_cast<uint64_t>(Ops::EqualMask(Ops::Load(elements + i), key))
+					| (static_cast<uint64_t>(Ops::EqualMask(Ops::Load(elements + i + lanes), key)) << lanes)
+					| (static_cast<uint64_t>(Ops::EqualMask(Ops::Load(elements + i + 2u * lanes), key)) << (2u * lanes))
+					| (static_cast<uint64_t>(Ops::EqualMask(Ops::Load(elements + i + 3u * lanes), key)) << (3u * lanes));
+				if (mask != 0u)
+				{
+					return i + LowestSetBit(mask);
+				}
+			}
+			for (; i + lanes <= count; i += lanes)
+			{
+				const uint32_t mask = Ops::EqualMask(Ops::Load(elements + i), key);
+				if (mask != 0u)
+				{
+					return i + LowestSetBit(mask);
+				}
+			}
+			for (; i < count; ++i)
+			{
+				if (elements[i] == value)
+				{
+					return i;
+				}
+			}
+			return count;
+		}
+	};
+
+	/**
+	 * Runs Kernel with the Ops of the given instruction set, which has to be supported by the CPU
+	 * (see GetInstructionSet). elements may be const (scans) or not (kernels that write). The upper halves of the AVX
+	 * registers are cleared afterwards, so following SSE code compiled without VEX encoding doesn't pay for the
+	 * state transition
+	 */
+	template <template <typename> class Kernel, typename T, typename... Args>
+	auto Run(InstructionSet instructionSet, T* elements, size_t count, Args... args) -> decltype(Kernel<Sse2::Ops<typename std::remove_const<T>::type>>::Run(elements, count, args...))
+	{
+		typedef typename std::remove_const<T>::type Element;
+		switch (instructionSet)
+		{
+#if SIMD_AVX512_KERNELS
+		case InstructionSet::Avx512:
+		{
+			const auto result = Kernel<Avx512::Ops<Element>>::Run(elements, count, args...);
+			_mm256_zeroupper();
+			return result;
+		}
+#endif
+#if SIMD_AVX2_KERNELS
+		case InstructionSet::Avx2:
+		{
+			const auto result = Kernel<Avx2::Ops<Element>>::Run(elements, count, args...);
+			_mm256_zeroupper();
+			return result;
+		}
+#endif
+		default:
+			return Kernel<Sse2::Ops<Element>>::Run(elements, count, args...);
+		}
+	}
+
+	inline size_t FirstDifferentByte(const uint8_t* left, const uint8_t* right, size_t byteCount)
+	{
+#if SIMD_AVX2_KERNELS
+		if (GetInstructionSet() != InstructionSet::Sse2)
+		{
+			return Avx2::FirstDifferentByte(left, right, byteCount);
+		}
+#endif
+		return Sse2::FirstDifferentByte(left, right, byteCount);
+	}
+
+	/**
+	 * A single core can't keep up with the memory bandwidth, so vectors of at least this size are split into page
+	 * aligned blocks (see Parallel::PageAlignedPartition) that run the kernel on the ThreadPool
+	 */
+	static const size_t PARALLEL_SCAN_BYTES = 4 * 1024 * 1024;
+
+	/**
+	 * Runs Kernel on the whole range and folds the block results with combine, starting from init. Blocks that
+	 * don't get any elements keep init, which therefore has to be neutral for combine
+	 */
+	template <template <typename> class Kernel, typename T, typename Result, typename Combine, typename... Args>
+	Result Reduce(const T* elements, size_t count, Result init, Combine combine, Args... args)
+	{
+		const InstructionSet instructionSet = GetInstructionSet();
+		if (count * sizeof(T) < PARALLEL_SCAN_BYTES)
+		{
+			return count == 0u ? init : combine(init, Run<Kernel>(instructionSet, elements, count, args...));
+		}
+
+		const Parallel::PageAlignedPartition partition(0u, count, sizeof(T), VirtualMemory::GetPageSize());
+		Vector<Result> partials;
+		partials.resize(partition.GetBlockCount(), init);
+		Result* const blockResults = partials.data();
+		Parallel::ForEachPageAlignedBlock(partition, [instructionSet, elements, blockResults, args...](size_t block, size_t blockBegin, size_t blockEnd)
+		{
+			blockResults[block] = Run<Kernel>(instructionSet, elements + blockBegin, blockEnd - blockBegin, args...);
+		});
+
+		Result result = init;
+		for (size_t block = 0u; block < partials.size(); ++block)
+		{
+			result = combine(result, blockResults[block]);
+		}
+		return result;
+	}
+}
+
+/**
+ * simd_sum returns the sum of all elements (0 for an empty vector) of a vector of 32 / 64 bit integers, float or
+ * double. Integer sums wrap around, float sums are added up in a different order than a loop would (see Simd::SumKernel)
+ */
+template <typename T>
+T simd_sum(const Vector<T>& vector)
+{
+	typedef typename Simd::KernelType<T>::Type KernelT;
+	const KernelT* const elements = reinterpret_cast<const KernelT*>(vector.data());
+	return static_cast<T>(Simd::Reduce<Simd::SumKernel>(elements, vector.size(), KernelT(0), [](KernelT a, KernelT b) { return static_cast<KernelT>(a + b); }));
+}
+
+/**
+ * simd_min / simd_max return the smallest / largest element of a non empty vector. The result for vectors containing
+ * NaNs is undefined
+ */
+template <typename T>
+T simd_min(const Vector<T>& vector)
+{
+	{ const bool isEmpty = vector.size() == 0u; assert("simd_min of an empty vector" && !isEmpty); }
+	typedef typename Simd::KernelType<T>::Type KernelT;
+	const KernelT* const elements = reinterpret_cast<const KernelT*>(vector.data());
+	return static_cast<T>(Simd::Reduce<Simd::MinKernel>(elements, vector.size(), elements[0], [](KernelT a, KernelT b) { return b < a ? b : a; }));
+}
+
+template <typename T>
+T simd_max(const Vector<T>& vector)
+{
+	{ const bool isEmpty = vector.size() == 0u; assert("simd_max of an empty vector" && !isEmpty); }
+	typedef typename Simd::KernelType<T>::Type KernelT;
+	const KernelT* const elements = reinterpret_cast<const KernelT*>(vector.data());
+	return static_cast<T>(Simd::Reduce<Simd::MaxKernel>(elements, vector.size(), elements[0], [](KernelT a, KernelT b) { return a < b ? b : a; }));
+}
+
+/**
+ * simd_count_if_equal returns how many elements compare equal to value (operator==, so NaNs never match)
+ */
+template <typename T>
+size_t simd_count_if_equal(const Vector<T>& vector, typename Vector<T>::value_type value)
+{
+	typedef typename Simd::KernelType<T>::Type KernelT;
+	const KernelT* const elements = reinterpret_cast<const KernelT*>(vector.data());
+	return Simd::Reduce<Simd::CountEqualKernel>(elements, vector.size(), size_t(0u), [](size_t a, size_t b) { return a + b; }, static_cast<KernelT>(value));
+}
+
+/**
+ * simd_find returns an iterator to the first element equal to value, or end() if there is none. The scan stops at
+ * the first match, so it runs on the calling thread only
+ */
+template <typename T>
+typename Vector<T>::const_iterator simd_find(const Vector<T>& vector, typename Vector<T>::value_type value)
+{
+	typedef typename Simd::KernelType<T>::Type KernelT;
+	const KernelT* const elements = reinterpret_cast<const KernelT*>(vector.data());
+	return vector.begin() + Simd::Run<Simd::FindEqualKernel>(Simd::GetInstructionSet(), elements, vector.size(), static_cast<KernelT>(value));
+}
+
+/**
+ * simd_any_of returns whether any element equals value
+ */
+template <typename T>
+bool simd_any_of(const Vector<T>& vector, typename Vector<T>::value_type value)
+{
+	return simd_find(vector, value) != vector.end();
+}
+
+/**
+ * Expressions namespace holds the lazy element-wise expressions built by the arithmetic operators, map and zip on
+ * vectors. An expression only stores its operands (vectors by pointer, scalars and sub expressions by value),
+ * nothing is computed until it is assigned to a Vector, which then evaluates the whole expression in one pass:
+ *     result = a * 2.0f + b;   // one loop over a, b and result, no temporary vectors
+ * The operand vectors have to outlive the expression. Every node provides value_type, size() and
+ * operator[](index) for the evaluation element by element. Nodes with IS_VECTORIZABLE also provide
+ * Load<Ops>(index), which evaluates a whole register at once (see Simd). map and zip call arbitrary functions,
+ * so expressions containing them are evaluated element by element
+ */
+namespace Expressions
+{
+	// Size of scalar operands, they match any other size
+	static const size_t BROADCAST_SIZE = SIZE_MAX;
+
+	size_t CombineSizes(size_t leftSize, size_t rightSize)
+	{
+		if (leftSize == BROADCAST_SIZE)
+		{
+			return rightSize;
+		}
+		if (rightSize == BROADCAST_SIZE)
+		{
+			return leftSize;
+		}
+		{ const bool isSizeEqual = leftSize == rightSize; assert("Expression operands differ in size" && isSizeEqual); }
+		return leftSize;
+	}
+
+	template <typename T>
+	class VectorOperand
+	{
+	public:
+		typedef T value_type;
+		static const bool IS_VECTORIZABLE = true;
+
+		explicit VectorOperand(const Vector<T>& vector) : m_elements(vector.data()), m_size(vector.size()) {}
+
+		size_t size(void) const { return m_size; }
+		T operator[](size_t index) const { return m_elements[index]; }
+		template <typename Ops>
+		typename Ops::Register Load(size_t index) const { return Ops::Load(m_elements + index); }
+
+	private:
+		const T* m_elements;
+		size_t m_size;
+	};
+
+	template <typename T>
+	class ScalarOperand
+	{
+	public:
+		typedef T value_type;
+		static const bool IS_VECTORIZABLE = true;
+
+		explicit ScalarOperand(T value) : m_value(value) {}
+
+		size_t size(void) const { return BROADCAST_SIZE; }
+		T operator[](size_t) const { return m_value; }
+		template <typename Ops>
+		typename Ops::Register Load(size_t) const { return Ops::Broadcast(m_value); }
+
+	private:
+		T m_value;
+	};
+
+	struct Plus
+	{
+		template <typename T>
+		static T Apply(T a, T b) { return static_cast<T>(a + b); }
+		template <typename Ops>
+		static typename Ops::Register Apply(typename Ops::Register a, typename Ops::Register b) { return Ops::Add(a, b); }
+	};
+
+	struct Minus
+	{
+		template <typename T>
+		static T Apply(T a, T b) { return static_cast<T>(a - b); }
+		template <typename Ops>
+		static typename Ops::Register Apply(typename Ops::Register a, typename Ops::Register b) { return Ops::Sub(a, b); }
+	};
+
+	struct Multiplies
+	{
+		template <typename T>
+		static T Apply(T a, T b) { return static_cast<T>(a * b); }
+		template <typename Ops>
+		static typename Ops::Register Apply(typename Ops::Register a, typename Ops::Register b) { return Ops::Mul(a, b); }
+	};
+
+	struct Divides
+	{
+		template <typename T>
+		static T Apply(T a, T b) { return static_cast<T>(a / b); }
+		template <typename Ops>
+		static typename Ops::Register Apply(typename Ops::Register a, typename Ops::Register b) { return Ops::Div(a, b); }
+	};
+
+	template <typename Left, typename Right, typename Operation>
+	class BinaryExpression
+	{
+	public:
+		typedef typename Left::value_type value_type;
+		static const bool IS_VECTORIZABLE = Left::IS_VECTORIZABLE && Right::IS_VECTORIZABLE;
+
+		BinaryExpression(const Left& left, const Right& right) : m_left(left), m_right(right), m_size(CombineSizes(left.size(), right.size())) {}
+
+		size_t size(void) const { return m_size; }
+		value_type operator[](size_t index) const { return Operation::template Apply<value_type>(m_left[index], m_right[index]); }
+		template <typename Ops>
+		typename Ops::Register Load(size_t index) const { return Operation::template Apply<Ops>(m_left.template Load<Ops>(index), m_right.template Load<Ops>(index)); }
+
+	private:
+		Left m_left;
+		Right m_right;
+		size_t m_size;
+	};
+
+	template <typename Source, typename Function>
+	class MapExpression
+	{
+	public:
+		typedef typename std::decay<decltype(std::declval<const Function&>()(std::declval<typename Source::value_type>()))>::type value_type;
+		static const bool IS_VECTORIZABLE = false;
+
+		MapExpression(const Source& source, Function function) : m_source(source), m_function(function) {}
+
+		size_t size(void) const { return m_source.size(); }
+		value_type operator[](size_t index) const { return m_function(m_source[index]); }
+
+	private:
+		Source m_source;
+		Function m_function;
+	};
+
+	template <typename Left, typename Right, typename Function>
+	class ZipExpression
+	{
+	public:
+		typedef typename std::decay<decltype(std::declval<const Function&>()(std::declval<typename Left::value_type>(), std::declval<typename Right::value_type>()))>::type value_type;
+		static const bool IS_VECTORIZABLE = false;
+
+		ZipExpression(const Left& left, const Right& right, Function function) : m_left(left), m_right(right), m_function(function), m_size(CombineSizes(left.size(), right.size())) {}
+
+		size_t size(void) const { return m_size; }
+		value_type operator[](size_t index) const { return m_function(m_left[index], m_right[index]); }
+
+	private:
+		Left m_left;
+		Right m_right;
+		Function m_function;
+		size_t m_size;
+	};
+
+	template <typename E>
+	struct IsExpression : std::false_type {};
+	template <typename Left, typename Right, typename Operation>
+	struct IsExpression<BinaryExpression<Left, Right, Operation>> : std::true_type {};
+	template <typename Source, typename Function>
+	struct IsExpression<MapExpression<Source, Function>> : std::true_type {};
+	template <typename Left, typename Right, typename Function>
+	struct IsExpression<ZipExpression<Left, Right, Function>> : std::true_type {};
+
+	/**
+	 * Operand describes how an argument of an operator, map or zip becomes a node: vectors are wrapped, expressions
+	 * are taken as they are. Everything else (IS_NODE false) can only be a scalar next to a node
+	 */
+	template <typename X, typename Enable = void>
+	struct Operand
+	{
+		static const bool IS_NODE = false;
+		typedef void Element;
+	};
+
+	template <typename T>
+	struct Operand<Vector<T>>
+	{
+		static const bool IS_NODE = true;
+		typedef T Element;
+		typedef VectorOperand<T> Type;
+		static Type Make(const Vector<T>& vector) { return Type(vector); }
+	};
+
+	template <typename E>
+	struct Operand<E, typename std::enable_if<IsExpression<E>::value>::type>
+	{
+		static const bool IS_NODE = true;
+		typedef typename E::value_type Element;
+		typedef E Type;
+		static const E& Make(const E& expression) { return expression; }
+	};
+
+	/**
+	 * Binary picks the node for left Operation right. Two nodes need the same element type, a scalar is converted
+	 * to the element type of the node next to it. Other combinations have no Type, so the operators drop out of
+	 * overload resolution for them
+	 */
+	template <typename Left, typename Right, typename Operation, typename Enable = void>
+	struct Binary {};
+
+	template <typename Left, typename Right, typename Operation>
+	struct Binary<Left, Right, Operation, typename std::enable_if<Operand<Left>::IS_NODE && Operand<Right>::IS_NODE
+		&& std::is_same<typename Operand<Left>::Element, typename Operand<Right>::Element>::value>::type>
+	{
+		typedef BinaryExpression<typename Operand<Left>::Type, typename Operand<Right>::Type, Operation> Type;
+		static Type Make(const Left& left, const Right& right) { return Type(Operand<Left>::Make(left), Operand<Right>::Make(right)); }
+	};
+
+	template <typename Left, typename Right, typename Operation>
+	struct Binary<Left, Right, Operation, typename std::enable_if<Operand<Left>::IS_NODE && std::is_arithmetic<Right>::value>::type>
+	{
+		typedef typename Operand<Left>::Element Element;
+		typedef BinaryExpression<typename Operand<Left>::Type, ScalarOperand<Element>, Operation> Type;
+		static Type Make(const Left& left, Right right) { return Type(Operand<Left>::Make(left), ScalarOperand<Element>(static_cast<Element>(right))); }
+	};
+
+	template <typename Left, typename Right, typename Operation>
+	struct Binary<Left, Right, Operation, typename std::enable_if<std::is_arithmetic<Left>::value && Operand<Right>::IS_NODE>::type>
+	{
+		typedef typename Operand<Right>::Element Element;
+		typedef BinaryExpression<ScalarOperand<Element>, typename Operand<Right>::Type, Operation> Type;
+		static Type Make(Left left, const Right& right) { return Type(ScalarOperand<Element>(static_cast<Element>(left)), Operand<Right>::Make(right)); }
+	};
+
+	/**
+	 * Writes one register per iteration straight into the target's committed pages, the remainder element by element
+	 */
+	template <typename Expression>
+	struct EvaluateKernel
+	{
+		template <typename Ops>
+		struct Kernel
+		{
+			typedef typename Ops::Element T;
+
+			static size_t Run(T* target, size_t count, const Expression& expression, size_t offset)
+			{
+				size_t i = 0u;
+				for (; i + Ops::LANES <= count; i += Ops::LANES)
+				{
+					Ops::Store(target + i, expression.template Load<Ops>(offset + i));
+				}
+				for (; i < count; ++i)
+				{
+					target[i] = expression[offset + i];
+				}
+				return count;
+			}
+		};
+	};
+
+	template <typename Expression, typename T>
+	void EvaluateRange(const Expression& expression, T* target, size_t rangeBegin, size_t rangeEnd, std::true_type)
+	{
+		Simd::Run<EvaluateKernel<Expression>::template Kernel>(Simd::GetInstructionSet(), target + rangeBegin, rangeEnd - rangeBegin, expression, rangeBegin);
+	}
+
+	template <typename Expression, typename T>
+	void EvaluateRange(const Expression& expression, T* target, size_t rangeBegin, size_t rangeEnd, std::false_type)
+	{
+		for (size_t i = rangeBegin; i < rangeEnd; ++i)
+		{
+			target[i] = static_cast<T>(expression[i]);
+		}
+	}
+
+	/**
+	 * Evaluates the expression into the vector, which takes the size of the expression. Every element only depends on
+	 * the operand elements at the same index, so the target may be one of the operands (a = a * 2.0f + b).
+	 * Float / double expressions of operators only use the SIMD kernels, large ones are split into page aligned blocks
+	 * that run on the ThreadPool. T has to be trivially default constructible (see resize_uninitialized)
+	 */
+	template <typename Expression, typename T>
+	void Evaluate(const Expression& expression, Vector<T>& target)
+	{
+		typedef std::integral_constant<bool, Expression::IS_VECTORIZABLE && std::is_floating_point<T>::value
+			&& std::is_same<typename Expression::value_type, T>::value> IsVectorizable;
+
+		const size_t count = expression.size();
+		target.resize_uninitialized(count);
+		T* const elements = target.data();
+		if (count * sizeof(T) < Simd::PARALLEL_SCAN_BYTES)
+		{
+			EvaluateRange(expression, elements, 0u, count, IsVectorizable());
+			return;
+		}
+
+		const Parallel::PageAlignedPartition partition(0u, count, sizeof(T), VirtualMemory::GetPageSize());
+		Parallel::ForEachPageAlignedBlock(partition, [&expression, elements](size_t, size_t blockBegin, size_t blockEnd)
+		{
+			EvaluateRange(expression, elements, blockBegin, blockEnd, IsVectorizable());
+		});
+	}
+}
+
+template <typename T>
+template <typename Expression, typename>
+Vector<T>::Vector(const Expression& expression)
+	: m_size(0u)
+	, m_capacity(0u)
+	, m_pageSize(VirtualMemory::GetPageSize())
+	, m_virtual_mem_begin { VirtualMemory::ReserveAddressSpace(MAX_VECTOR_CAPACITY) }
+	, m_virtual_mem_end { reinterpret_cast<void*>(m_virtual_mem_begin.as_ptr + MAX_VECTOR_CAPACITY) }
+	, m_physical_mem_begin { m_virtual_mem_begin }
+	, m_physical_mem_end { m_virtual_mem_begin }
+	, m_internal_array { m_physical_mem_begin }
+	, m_isDestructionDeferred(false)
+{
+	Expressions::Evaluate(expression, *this);
+}
+
+template <typename T>
+template <typename Expression, typename>
+Vector<T>& Vector<T>::operator=(const Expression& expression)
+{
+	Expressions::Evaluate(expression, *this);
+	return *this;
+}
+
+/**
+ * Element-wise arithmetic on vectors and expressions, with scalars on either side. The result is a lazy expression
+ * that is computed when it is assigned to a Vector (see Expressions)
+ */
+template <typename Left, typename Right>
+typename Expressions::Binary<Left, Right, Expressions::Plus>::Type operator+(const Left& left, const Right& right)
+{
+	return Expressions::Binary<Left, Right, Expressions::Plus>::Make(left, right);
+}
+
+template <typename Left, typename Right>
+typename Expressions::Binary<Left, Right, Expressions::Minus>::Type operator-(const Left& left, const Right& right)
+{
+	return Expressions::Binary<Left, Right, Expressions::Minus>::Make(left, right);
+}
+
+template <typename Left, typename Right>
+typename Expressions::Binary<Left, Right, Expressions::Multiplies>::Type operator*(const Left& left, const Right& right)
+{
+	return Expressions::Binary<Left, Right, Expressions::Multiplies>::Make(left, right);
+}
+
+template <typename Left, typename Right>
+typename Expressions::Binary<Left, Right, Expressions::Divides>::Type operator/(const Left& left, const Right& right)
+{
+	return Expressions::Binary<Left, Right, Expressions::Divides>::Make(left, right);
+}
+
+/**
+ * map applies function to every element of a vector or expression, zip combines the elements of two of them at the
+ * same index. Both are lazy like the operators, function has to be safe to call from several threads at once
+ */
+template <typename Source, typename Function>
+Expressions::MapExpression<typename Expressions::Operand<Source>::Type, Function> map(const Source& source, Function function)
+{
+	return Expressions::MapExpression<typename Expressions::Operand<Source>::Type, Function>(Expressions::Operand<Source>::Make(source), function);
+}
+
+template <typename Left, typename Right, typename Function>
+Expressions::ZipExpression<typename Expressions::Operand<Left>::Type, typename Expressions::Operand<Right>::Type, Function> zip(const Left& left, const Right& right, Function function)
+{
+	return Expressions::ZipExpression<typename Expressions::Operand<Left>::Type, typename Expressions::Operand<Right>::Type, Function>(
+		Expressions::Operand<Left>::Make(left), Expressions::Operand<Right>::Make(right), function);
+}
+
+/**
+ * IndexedAccess namespace holds the kernels behind gather and scatter. Random indices into a large vector miss the
+ * cache on almost every access and the hardware prefetcher can't predict them, so the kernels prefetch the element
+ * a few indices ahead: the misses of the next iterations overlap instead of being waited for one after the other
+ */
+namespace IndexedAccess
+{
+	// How many indices the kernels look ahead by default, roughly the misses a core keeps in flight
+	static const size_t DEFAULT_PREFETCH_DISTANCE = 32;
+
+	template <typename T, typename Index>
+	void GatherRange(const T* source, const Index* indices, T* target, size_t count, size_t prefetchDistance)
+	{
+		const size_t prefetchEnd = count > prefetchDistance ? count - prefetchDistance : 0u;
+		size_t i = 0u;
+		for (; i < prefetchEnd; ++i)
+		{
+			CompilerHints::Prefetch(source + indices[i + prefetchDistance]);
+			target[i] = source[indices[i]];
+		}
+		for (; i < count; ++i)
+		{
+			target[i] = source[indices[i]];
+		}
+	}
+
+#if SIMD_AVX2_KERNELS
+	/**
+	 * AVX2 gathers load 4 / 8 elements of 4 / 8 bytes per instruction, 32 and 64 bit indices are supported.
+	 * The elements are gathered as integers of the same size, any trivially copyable type works
+	 */
+	template <size_t ElementSize, size_t IndexSize> struct Avx2Gather;
+
+	template <>
+	struct Avx2Gather<4, 4>
+	{
+		static const size_t LANES = 8;
+		static void Run(const uint32_t* source, const uint32_t* indices, uint32_t* target)
+		{
+			const __m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target), _mm256_i32gather_epi32(reinterpret_cast<const int*>(source), offsets, 4));
+		}
+	};
+
+	template <>
+	struct Avx2Gather<4, 8>
+	{
+		static const size_t LANES = 4;
+		static void Run(const uint32_t* source, const uint64_t* indices, uint32_t* target)
+		{
+			const __m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(target), _mm256_i64gather_epi32(reinterpret_cast<const int*>(source), offsets, 4));
+		}
+	};
+
+	template <>
+	struct Avx2Gather<8, 4>
+	{
+		static const size_t LANES = 4;
+		static void Run(const uint64_t* source, const uint32_t* indices, uint64_t* target)
+		{
+			const __m128i offsets = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target), _mm256_i32gather_epi64(reinterpret_cast<const long long*>(source), offsets, 8));
+		}
+	};
+
+	template <>
+	struct Avx2Gather<8, 8>
+	{
+		static const size_t LANES = 4;
+		static void Run(const uint64_t* source, const uint64_t* indices, uint64_t* target)
+		{
+			const __m256i offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(target), _mm256_i64gather_epi64(reinterpret_cast<const long long*>(source), offsets, 8));
+		}
+	};
+
+	template <typename Element, typename Index>
+	void GatherRangeAvx2(const Element* source, const Index* indices, Element* target, size_t count, size_t prefetchDistance)
+	{
+		typedef Avx2Gather<sizeof(Element), sizeof(Index)> Gather;
+		const size_t lanes = Gather::LANES;
+		const size_t prefetchEnd = count > prefetchDistance + lanes ? count - prefetchDistance - lanes : 0u;
+		size_t i = 0u;
+		for (; i < prefetchEnd; i += lanes)
+		{
+			for (size_t lane = 0u; lane < lanes; ++lane)
+			{
+				CompilerHints::Prefetch(source + indices[i + prefetchDistance + lane]);
+			}
+			Gather::Run(source, indices + i, target + i);
+		}
+		for (; i + lanes <= count; i += lanes)
+		{
+			Gather::Run(source, indices + i, target + i);
+		}
+		_mm256_zeroupper();
+		for (; i < count; ++i)
+		{
+			target[i] = source[indices[i]];
+		}
+	}
+#endif
+
+	/**
+	 * Trivially copyable elements of 4 / 8 bytes with 4 / 8 byte indices use the AVX2 gather if the CPU has it
+	 */
+	template <typename T, typename Index>
+	void Gather(const T* source, const Index* indices, T* target, size_t count, size_t prefetchDistance, std::true_type)
+	{
+		typedef typename Sorting::UnsignedOfSize<sizeof(T)>::Type Element;
+		typedef typename Sorting::UnsignedOfSize<sizeof(Index)>::Type KernelIndex;
+#if SIMD_AVX2_KERNELS
+		if (Simd::GetInstructionSet() != Simd::InstructionSet::Sse2)
+		{
+			GatherRangeAvx2(reinterpret_cast<const Element*>(source), reinterpret_cast<const KernelIndex*>(indices), reinterpret_cast<Element*>(target), count, prefetchDistance);
+			return;
+		}
+#endif
+		GatherRange(reinterpret_cast<const Element*>(source), reinterpret_cast<const KernelIndex*>(indices), reinterpret_cast<Element*>(target), count, prefetchDistance);
+	}
+
+	template <typename T, typename Index>
+	void Gather(const T* source, const Index* indices, T* target, size_t count, size_t prefetchDistance, std::false_type)
+	{
+		GatherRange(source, indices, target, count, prefetchDistance);
+	}
+
+	template <typename T>
+	void PrepareTarget(Vector<T>& target, size_t count, std::true_type)
+	{
+		target.resize_uninitialized(count);
+	}
+
+	template <typename T>
+	void PrepareTarget(Vector<T>& target, size_t count, std::false_type)
+	{
+		target.resize(count);
+	}
+}
+
+/**
+ * gather sets target[i] = source[indices[i]] for every index, target takes the size of indices. The element
+ * prefetchDistance indices ahead is prefetched (see IndexedAccess), large trivially copyable gathers run in page
+ * aligned blocks on the ThreadPool. All indices have to be smaller than source.size()
+ */
+template <typename T, typename Index>
+void gather(const Vector<T>& source, const Vector<Index>& indices, Vector<T>& target, size_t prefetchDistance = IndexedAccess::DEFAULT_PREFETCH_DISTANCE)
+{
+	static_assert(std::is_integral<Index>::value, "gather requires integral indices");
+	assert("Gather index out of range" && (indices.empty() || static_cast<size_t>(*std::max_element(indices.begin(), indices.end())) < source.size()));
+	assert("Gather target aliases the source" && &source != &target);
+
+	typedef std::integral_constant<bool, std::is_trivially_copyable<T>::value && std::is_trivially_default_constructible<T>::value> IsTrivial;
+	typedef std::integral_constant<bool, IsTrivial::value && (sizeof(T) == 4u || sizeof(T) == 8u) && (sizeof(Index) == 4u || sizeof(Index) == 8u)> IsHardwareGather;
+
+	const size_t count = indices.size();
+	IndexedAccess::PrepareTarget(target, count, IsTrivial());
+	const T* const elements = source.data();
+	const Index* const offsets = indices.data();
+	T* const results = target.data();
+	if (!IsTrivial::value || count * sizeof(T) < Simd::PARALLEL_SCAN_BYTES)
+	{
+		IndexedAccess::Gather(elements, offsets, results, count, prefetchDistance, IsHardwareGather());
+		return;
+	}
+
+	const Parallel::PageAlignedPartition partition(0u, count, sizeof(T), VirtualMemory::GetPageSize());
+	Parallel::ForEachPageAlignedBlock(partition, [elements, offsets, results, prefetchDistance](size_t, size_t blockBegin, size_t blockEnd)
+	{
+		IndexedAccess::Gather(elements, offsets + blockBegin, results + blockBegin, blockEnd - blockBegin, prefetchDistance, IsHardwareGather());
+	});
+}
+
+/**
+ * scatter sets target[indices[i]] = values[i] for every index, prefetching like gather. It runs on the calling
+ * thread, so for duplicate indices the last value wins. All indices have to be smaller than target.size()
+ */
+template <typename T, typename Index>
+void scatter(const Vector<T>& values, const Vector<Index>& indices, Vector<T>& target, size_t prefetchDistance = IndexedAccess::DEFAULT_PREFETCH_DISTANCE)
+{
+	static_assert(std::is_integral<Index>::value, "scatter requires integral indices");
+	{ const bool isSizeEqual = values.size() == indices.size(); assert("Scatter needs one index per value" && isSizeEqual); }
+	assert("Scatter index out of range" && (indices.empty() || static_cast<size_t>(*std::max_element(indices.begin(), indices.end())) < target.size()));
+
+	const size_t count = indices.size();
+	const T* const elements = values.data();
+	const Index* const offsets = indices.data();
+	T* const results = target.data();
+	const size_t prefetchEnd = count > prefetchDistance ? count - prefetchDistance : 0u;
+	size_t i = 0u;
+	for (; i < prefetchEnd; ++i)
+	{
+		CompilerHints::Prefetch(results + offsets[i + prefetchDistance]);
+		results[offsets[i]] = elements[i];
+	}
+	for (; i < count; ++i)
+	{
+		results[offsets[i]] = elements[i];
+	}
+}
+
+/**
+ * Comparison namespace holds the element search behind mismatch and the comparison operators
+ */
+namespace Comparison
+{
+	template <typename T>
+	size_t Mismatch(const T* left, const T* right, size_t count, std::false_type)
+	{
+		for (size_t i = 0u; i < count; ++i)
+		{
+			if (!(left[i] == right[i]))
+			{
+				return i;
+			}
+		}
+		return count;
+	}
+
+	/**
+	 * Trivially comparable elements are compared as bytes, a cache line at a time. Large ranges are split into page
+	 * aligned blocks on the ThreadPool, blocks that start behind an already found difference are skipped
+	 */
+	template <typename T>
+	size_t Mismatch(const T* left, const T* right, size_t count, std::true_type)
+	{
+		const uint8_t* const leftBytes = reinterpret_cast<const uint8_t*>(left);
+		const uint8_t* const rightBytes = reinterpret_cast<const uint8_t*>(right);
+		if (count * sizeof(T) < Simd::PARALLEL_SCAN_BYTES)
+		{
+			return Simd::FirstDifferentByte(leftBytes, rightBytes, count * sizeof(T)) / sizeof(T);
+		}
+
+		std::atomic<size_t> firstMismatch(count);
+		const Parallel::PageAlignedPartition partition(0u, count, sizeof(T), VirtualMemory::GetPageSize());
+		Parallel::ForEachPageAlignedBlock(partition, [leftBytes, rightBytes, &firstMismatch](size_t, size_t blockBegin, size_t blockEnd)
+		{
+			if (blockBegin >= firstMismatch.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			const size_t byteCount = (blockEnd - blockBegin) * sizeof(T);
+			const size_t byteIndex = Simd::FirstDifferentByte(leftBytes + blockBegin * sizeof(T), rightBytes + blockBegin * sizeof(T), byteCount);
+			if (byteIndex < byteCount)
+			{
+				const size_t mismatchIndex = blockBegin + byteIndex / sizeof(T);
+				size_t current = firstMismatch.load(std::memory_order_relaxed);
+				while (mismatchIndex < current && !firstMismatch.compare_exchange_weak(current, mismatchIndex, std::memory_order_relaxed))
+				{
+				}
+			}
+		});
+		return firstMismatch.load(std::memory_order_relaxed);
+	}
+}
+
+/**
+ * Hashing namespace holds the byte hash behind content_hash
+ */
+namespace Hashing
+{
+	static const uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+	static const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+	static const uint64_t PRIME_3 = 0x165667B19E3779F9ull;
+	static const uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ull;
+	static const uint64_t PRIME_5 = 0x27D4EB2F165667C5ull;
+
+	// Vectors larger than this are hashed in chunks of this size on the ThreadPool
+	static const size_t PARALLEL_CHUNK_BYTES = 1024 * 1024;
+
+	inline uint64_t RotateLeft(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	inline uint64_t Read64(const uint8_t* bytes)
+	{
+		uint64_t value;
+		std::memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+
+	inline uint64_t Round(uint64_t accumulator, uint64_t input)
+	{
+		return RotateLeft(accumulator + input * PRIME_2, 31) * PRIME_1;
+	}
+
+	inline uint64_t MergeRound(uint64_t hash, uint64_t accumulator)
+	{
+		return (hash ^ Round(0u, accumulator)) * PRIME_1 + PRIME_4;
+	}
+
+	/**
+	 * 64 bit multiply / rotate hash of the bytes, compatible with XXH64. Four independent lanes consume 32 bytes per
+	 * iteration, so the multiplies overlap and the hash runs at several bytes per cycle
+	 */
+	uint64_t HashBytes(const void* data, size_t byteCount, uint64_t seed)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		const uint8_t* const end = bytes + byteCount;
+		uint64_t hash;
+
+		if (byteCount >= 32u)
+		{
+			uint64_t lane1 = seed + PRIME_1 + PRIME_2;
+			uint64_t lane2 = seed + PRIME_2;
+			uint64_t lane3 = seed;
+			uint64_t lane4 = seed - PRIME_1;
+			for (; bytes + 32 <= end; bytes += 32)
+			{
+				lane1 = Round(lane1, Read64(bytes));
+				lane2 = Round(lane2, Read64(bytes + 8));
+				lane3 = Round(lane3, Read64(bytes + 16));
+				lane4 = Round(lane4, Read64(bytes + 24));
+			}
+			hash = RotateLeft(lane1, 1) + RotateLeft(lane2, 7) + RotateLeft(lane3, 12) + RotateLeft(lane4, 18);
+			hash = MergeRound(hash, lane1);
+			hash = MergeRound(hash, lane2);
+			hash = MergeRound(hash, lane3);
+			hash = MergeRound(hash, lane4);
+		}
+		else
+		{
+			hash = seed + PRIME_5;
+		}
+
+		hash += byteCount;
+		for (; bytes + 8 <= end; bytes += 8)
+		{
+			hash = RotateLeft(hash ^ Round(0u, Read64(bytes)), 27) * PRIME_1 + PRIME_4;
+		}
+		if (bytes + 4 <= end)
+		{
+			uint32_t value;
+			std::memcpy(&value, bytes, sizeof(value));
+			hash = RotateLeft(hash ^ (value * PRIME_1), 23) * PRIME_2 + PRIME_3;
+			bytes += 4;
+		}
+		for (; bytes < end; ++bytes)
+		{
+			hash = RotateLeft(hash ^ (*bytes * PRIME_5), 11) * PRIME_1;
+		}
+
+		hash ^= hash >> 33;
+		hash *= PRIME_2;
+		hash ^= hash >> 29;
+		hash *= PRIME_3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+}
+
+/**
+ * mismatch returns the index of the first element where the vectors differ. If one vector is a prefix of the
+ * other the size of the shorter one is returned. Trivially comparable types (see TypeTraits::IsTriviallyComparable)
+ * are compared as bytes with SIMD, all others with operator==
+ */
+template <typename T>
+size_t mismatch(const Vector<T>& left, const Vector<T>& right)
+{
+	const size_t commonSize = left.size() < right.size() ? left.size() : right.size();
+	return Comparison::Mismatch(left.data(), right.data(), commonSize, std::integral_constant<bool, TypeTraits::IsTriviallyComparable<T>::value>());
+}
+
+template <typename T>
+bool operator==(const Vector<T>& left, const Vector<T>& right)
+{
+	return left.size() == right.size() && mismatch(left, right) == left.size();
+}
+
+template <typename T>
+bool operator!=(const Vector<T>& left, const Vector<T>& right)
+{
+	return !(left == right);
+}
+
+/**
+ * Lexicographic order like std::vector: the first differing element decides, a prefix is smaller than the longer vector
+ */
+template <typename T>
+bool operator<(const Vector<T>& left, const Vector<T>& right)
+{
+	const size_t index = mismatch(left, right);
+	if (index < left.size() && index < right.size())
+	{
+		return left[index] < right[index];
+	}
+	return left.size() < right.size();
+}
+
+template <typename T>
+bool operator>(const Vector<T>& left, const Vector<T>& right)
+{
+	return right < left;
+}
+
+template <typename T>
+bool operator<=(const Vector<T>& left, const Vector<T>& right)
+{
+	return !(right < left);
+}
+
+template <typename T>
+bool operator>=(const Vector<T>& left, const Vector<T>& right)
+{
+	return !(left < right);
+}
+
+/**
+ * content_hash returns a 64 bit hash of the elements, vectors that compare equal have the same hash. Vectors above
+ * 1MB are hashed in fixed 1MB chunks on the ThreadPool and the chunk hashes are hashed once more, so the result
+ * does not depend on the number of threads
+ */
+template <typename T>
+uint64_t content_hash(const Vector<T>& vector)
+{
+	static_assert(TypeTraits::IsTriviallyComparable<T>::value, "content_hash requires a trivially comparable type");
+
+	const uint8_t* const bytes = reinterpret_cast<const uint8_t*>(vector.data());
+	const size_t byteCount = vector.size() * sizeof(T);
+	if (byteCount <= Hashing::PARALLEL_CHUNK_BYTES)
+	{
+		return Hashing::HashBytes(bytes, byteCount, 0u);
+	}
+
+	const size_t chunkCount = (byteCount + Hashing::PARALLEL_CHUNK_BYTES - 1u) / Hashing::PARALLEL_CHUNK_BYTES;
+	Vector<uint64_t> chunkHashes;
+	chunkHashes.resize_uninitialized(chunkCount);
+	uint64_t* const hashes = chunkHashes.data();
+	Parallel::ForEachRange(byteCount, Hashing::PARALLEL_CHUNK_BYTES, [bytes, hashes](size_t chunk, size_t chunkBegin, size_t chunkEnd)
+	{
+		hashes[chunk] = Hashing::HashBytes(bytes + chunkBegin, chunkEnd - chunkBegin, chunk);
+	});
+	return Hashing::HashBytes(hashes, chunkCount * sizeof(uint64_t), byteCount);
+}
+
+/**
+ * Scanning namespace holds the building blocks of inclusive_scan and exclusive_scan
+ */
+namespace Scanning
+{
+	/**
+	 * Sums of 32 / 64 bit integers, float and double are scanned with SSE2 registers: a prefix sum inside the
+	 * register (log2(lanes) shift + add steps), plus the running total of all elements before the register
+	 */
+	template <typename T>
+	struct IsSimdSummable : std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && (sizeof(T) == 4u || sizeof(T) == 8u)> {};
+
+	template <typename T, bool IsFloatingPoint = std::is_floating_point<T>::value, size_t Size = sizeof(T)> struct SumScanOps;
+
+	template <typename T>
+	struct SumScanOps<T, false, 4>
+	{
+		typedef __m128i Register;
+		static const size_t LANES = 4;
+
+		static Register Load(const T* source) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)); }
+		static void Store(T* target, Register value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(target), value); }
+		static Register Broadcast(T value) { return _mm_set1_epi32(static_cast<int>(value)); }
+		static Register Add(Register a, Register b) { return _mm_add_epi32(a, b); }
+		static Register PrefixSum(Register x)
+		{
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+			return _mm_add_epi32(x, _mm_slli_si128(x, 8));
+		}
+		static Register ShiftUp(Register x) { return _mm_slli_si128(x, 4); }
+		static Register BroadcastLast(Register x) { return _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3)); }
+	};
+
+	template <typename T>
+	struct SumScanOps<T, false, 8>
+	{
+		typedef __m128i Register;
+		static const size_t LANES = 2;
+
+		static Register Load(const T* source) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)); }
+		static void Store(T* target, Register value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(target), value); }
+		static Register Broadcast(T value) { return _mm_set1_epi64x(static_cast<long long>(value)); }
+		static Register Add(Register a, Register b) { return _mm_add_epi64(a, b); }
+		static Register PrefixSum(Register x) { return _mm_add_epi64(x, _mm_slli_si128(x, 8)); }
+		static Register ShiftUp(Register x) { return _mm_slli_si128(x, 8); }
+		static Register BroadcastLast(Register x) { return _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 2, 3, 2)); }
+	};
+
+	template <>
+	struct SumScanOps<float, true, 4>
+	{
+		typedef __m128 Register;
+		static const size_t LANES = 4;
+
+		static Register Load(const float* source) { return _mm_loadu_ps(source); }
+		static void Store(float* target, Register value) { _mm_storeu_ps(target, value); }
+		static Register Broadcast(float value) { return _mm_set1_ps(value); }
+		static Register Add(Register a, Register b) { return _mm_add_ps(a, b); }
+		static Register PrefixSum(Register x)
+		{
+			x = _mm_add_ps(x, ShiftUp(x));
+			return _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+		}
+		static Register ShiftUp(Register x) { return _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)); }
+		static Register BroadcastLast(Register x) { return _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3)); }
+	};
+
+	template <>
+	struct SumScanOps<double, true, 8>
+	{
+		typedef __m128d Register;
+		static const size_t LANES = 2;
+
+		static Register Load(const double* source) { return _mm_loadu_pd(source); }
+		static void Store(double* target, Register value) { _mm_storeu_pd(target, value); }
+		static Register Broadcast(double value) { return _mm_set1_pd(value); }
+		static Register Add(Register a, Register b) { return _mm_add_pd(a, b); }
+		static Register PrefixSum(Register x) { return _mm_add_pd(x, ShiftUp(x)); }
+		static Register ShiftUp(Register x) { return _mm_castsi128_pd(_mm_slli_si128(_mm_castpd_si128(x), 8)); }
+		static Register BroadcastLast(Register x) { return _mm_unpackhi_pd(x, x); }
+	};
+
+	/**
+	 * Scans count elements in place, starting from carry (the combination of everything before them), and returns
+	 * the combination of carry and all elements. Float sums are rounded in a different order than a loop would
+	 */
+	template <typename T, typename Op>
+	T ScanRange(T* elements, size_t count, T carry, Op& op, bool isExclusive, std::false_type)
+	{
+		for (size_t i = 0u; i < count; ++i)
+		{
+			if (isExclusive)
+			{
+				T value = elements[i];
+				elements[i] = carry;
+				carry = op(carry, value);
+			}
+			else
+			{
+				carry = op(carry, elements[i]);
+				elements[i] = carry;
+			}
+		}
+		return carry;
+	}
+
+	template <typename T, typename Op>
+	T ScanRange(T* elements, size_t count, T carry, Op& op, bool isExclusive, std::true_type)
+	{
+		typedef SumScanOps<T> Ops;
+		typename Ops::Register running = Ops::Broadcast(carry);
+		size_t i = 0u;
+		for (; i + Ops::LANES <= count; i += Ops::LANES)
+		{
+			const typename Ops::Register prefix = Ops::PrefixSum(Ops::Load(elements + i));
+			Ops::Store(elements + i, Ops::Add(running, isExclusive ? Ops::ShiftUp(prefix) : prefix));
+			running = Ops::BroadcastLast(Ops::Add(running, prefix));
+		}
+
+		T lanes[Ops::LANES];
+		Ops::Store(lanes, running);
+		return ScanRange(elements + i, count - i, lanes[0], op, isExclusive, std::false_type());
+	}
+
+	template <typename T, typename Op>
+	T ReduceRange(const T* elements, size_t count, T init, Op& op, std::false_type)
+	{
+		for (size_t i = 0u; i < count; ++i)
+		{
+			init = op(init, elements[i]);
+		}
+		return init;
+	}
+
+	template <typename T, typename Op>
+	T ReduceRange(const T* elements, size_t count, T init, Op&, std::true_type)
+	{
+		typedef typename Simd::KernelType<T>::Type KernelT;
+		return init + static_cast<T>(Simd::Run<Simd::SumKernel>(Simd::GetInstructionSet(), reinterpret_cast<const KernelT*>(elements), count));
+	}
+
+	/**
+	 * Small vectors are scanned in one pass. Large ones take two passes over page aligned blocks on the ThreadPool:
+	 * - Every block combines its elements
+	 * - The block results are scanned on the calling thread, which gives each block the carry of all blocks before it
+	 * - Every block scans its elements in place, starting from its carry
+	 * An inclusive scan has no init, its first element starts the scan
+	 */
+	template <typename T, typename Op, typename IsSum>
+	void Scan(Vector<T>& vector, const T& init, Op op, bool isExclusive, IsSum isSum)
+	{
+		T* const elements = vector.data();
+		const size_t count = vector.size();
+		if (count == 0u)
+		{
+			return;
+		}
+		if (count * sizeof(T) < Simd::PARALLEL_SCAN_BYTES)
+		{
+			if (isExclusive)
+			{
+				ScanRange(elements, count, init, op, true, isSum);
+			}
+			else
+			{
+				ScanRange(elements + 1u, count - 1u, elements[0], op, false, isSum);
+			}
+			return;
+		}
+
+		const Parallel::PageAlignedPartition partition(0u, count, sizeof(T), VirtualMemory::GetPageSize());
+		Vector<T> blockResults;
+		blockResults.resize(partition.GetBlockCount(), init);
+		T* const results = blockResults.data();
+		Parallel::ForEachPageAlignedBlock(partition, [elements, results, &op, isSum](size_t block, size_t blockBegin, size_t blockEnd)
+		{
+			results[block] = ReduceRange(elements + blockBegin + 1u, blockEnd - blockBegin - 1u, elements[blockBegin], op, isSum);
+		});
+
+		// Turn the block results into carries, the first block of an inclusive scan has none
+		bool hasCarry = isExclusive;
+		T carry = init;
+		for (size_t block = 0u; block < blockResults.size(); ++block)
+		{
+			size_t blockBegin;
+			size_t blockEnd;
+			if (!partition.GetBlock(block, blockBegin, blockEnd))
+			{
+				continue;
+			}
+			const T blockResult = results[block];
+			results[block] = carry;
+			carry = hasCarry ? op(carry, blockResult) : blockResult;
+			hasCarry = true;
+		}
+
+		Parallel::ForEachPageAlignedBlock(partition, [elements, results, &op, isExclusive, isSum](size_t block, size_t blockBegin, size_t blockEnd)
+		{
+			if (block == 0u && !isExclusive)
+			{
+				ScanRange(elements + 1u, blockEnd - 1u, elements[0], op, false, isSum);
+			}
+			else
+			{
+				ScanRange(elements + blockBegin, blockEnd - blockBegin, results[block], op, isExclusive, isSum);
+			}
+		});
+	}
+
+	template <typename T>
+	struct Plus
+	{
+		T operator()(const T& a, const T& b) const { return static_cast<T>(a + b); }
+	};
+}
+
+/**
+ * inclusive_scan replaces every element with the combination of itself and all elements before it, in place:
+ * [1, 2, 3] becomes [1, 3, 6]. op has to be associative and safe to call from several threads at once.
+ * Without op the elements are summed up, with SSE2 prefix sums for 32 / 64 bit integers, float and double
+ */
+template <typename T, typename Op>
+void inclusive_scan(Vector<T>& vector, Op op)
+{
+	Scanning::Scan(vector, T(), op, false, std::false_type());
+}
+
+template <typename T>
+void inclusive_scan(Vector<T>& vector)
+{
+	Scanning::Scan(vector, T(), Scanning::Plus<T>(), false, Scanning::IsSimdSummable<T>());
+}
+
+/**
+ * exclusive_scan replaces every element with the combination of init and all elements before it, in place:
+ * [1, 2, 3] with init 0 becomes [0, 1, 3]. This turns a vector of sizes into a vector of offsets
+ */
+template <typename T, typename Op>
+void exclusive_scan(Vector<T>& vector, typename Vector<T>::value_type init, Op op)
+{
+	Scanning::Scan(vector, init, op, true, std::false_type());
+}
+
+template <typename T>
+void exclusive_scan(Vector<T>& vector, typename Vector<T>::value_type init = T())
+{
+	Scanning::Scan(vector, init, Scanning::Plus<T>(), true, Scanning::IsSimdSummable<T>());
+}
+
+/**
+ * SetOperations namespace holds the kernels behind set_intersection, set_union and set_difference. The inputs are
+ * sorted ascending without duplicates (e.g. posting lists), the output is written with raw stores into a target
+ * that was grown once to the largest possible result
+ */
+namespace SetOperations
+{
+	// Inputs whose sizes differ by at least this factor are intersected by galloping through the larger one
+	static const size_t GALLOPING_RATIO = 32;
+
+	template <typename T>
+	bool IsStrictlySorted(const Vector<T>& vector)
+	{
+		for (size_t i = 1u; i < vector.size(); ++i)
+		{
+			if (!(vector[i - 1u] < vector[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Returns the first index in [rangeBegin, rangeEnd) whose element is not smaller than value. The distance is
+	 * doubled until it overshoots, then the last step is binary searched, so short jumps stay cheap
+	 */
+	template <typename T>
+	size_t Gallop(const T* elements, size_t rangeBegin, size_t rangeEnd, const T& value)
+	{
+		size_t bound = 1u;
+		while (rangeBegin + bound < rangeEnd && elements[rangeBegin + bound] < value)
+		{
+			bound *= 2u;
+		}
+		const size_t searchBegin = rangeBegin + bound / 2u;
+		const size_t searchEnd = rangeBegin + bound + 1u < rangeEnd ? rangeBegin + bound + 1u : rangeEnd;
+		return static_cast<size_t>(std::lower_bound(elements + searchBegin, elements + searchEnd, value) - elements);
+	}
+
+	/**
+	 * The merges are branchless: the current element is always stored and the output position only advances if it
+	 * belongs to the result, both inputs advance by comparison results instead of jumps
+	 */
+	template <typename T>
+	size_t IntersectMerge(const T* left, size_t leftCount, const T* right, size_t rightCount, T* target)
+	{
+		size_t i = 0u;
+		size_t j = 0u;
+		size_t k = 0u;
+		while (i < leftCount && j < rightCount)
+		{
+			const T x = left[i];
+			const T y = right[j];
+			target[k] = x;
+			k += static_cast<size_t>(!(x < y) && !(y < x));
+			i += static_cast<size_t>(!(y < x));
+			j += static_cast<size_t>(!(x < y));
+		}
+		return k;
+	}
+
+	template <typename T>
+	size_t UnionMerge(const T* left, size_t leftCount, const T* right, size_t rightCount, T* target)
+	{
+		size_t i = 0u;
+		size_t j = 0u;
+		size_t k = 0u;
+		while (i < leftCount && j < rightCount)
+		{
+			const T x = left[i];
+			const T y = right[j];
+			target[k++] = y < x ? y : x;
+			i += static_cast<size_t>(!(y < x));
+			j += static_cast<size_t>(!(x < y));
+		}
+		std::copy(left + i, left + leftCount, target + k);
+		k += leftCount - i;
+		std::copy(right + j, right + rightCount, target + k);
+		return k + rightCount - j;
+	}
+
+	template <typename T>
+	size_t DifferenceMerge(const T* left, size_t leftCount, const T* right, size_t rightCount, T* target)
+	{
+		size_t i = 0u;
+		size_t j = 0u;
+		size_t k = 0u;
+		while (i < leftCount && j < rightCount)
+		{
+			const T x = left[i];
+			const T y = right[j];
+			target[k] = x;
+			k += static_cast<size_t>(x < y);
+			i += static_cast<size_t>(!(y < x));
+			j += static_cast<size_t>(!(x < y));
+		}
+		std::copy(left + i, left + leftCount, target + k);
+		return k + leftCount - i;
+	}
+
+	template <typename T>
+	size_t IntersectGalloping(const T* small, size_t smallCount, const T* large, size_t largeCount, T* target)
+	{
+		size_t j = 0u;
+		size_t k = 0u;
+		for (size_t i = 0u; i < smallCount && j < largeCount; ++i)
+		{
+			j = Gallop(large, j, largeCount, small[i]);
+			if (j < largeCount && !(small[i] < large[j]))
+			{
+				target[k++] = small[i];
+				++j;
+			}
+		}
+		return k;
+	}
+
+	template <typename T>
+	size_t DifferenceGalloping(const T* left, size_t leftCount, const T* right, size_t rightCount, T* target)
+	{
+		size_t j = 0u;
+		size_t k = 0u;
+		for (size_t i = 0u; i < leftCount; ++i)
+		{
+			j = Gallop(right, j, rightCount, left[i]);
+			if (j == rightCount || left[i] < right[j])
+			{
+				target[k++] = left[i];
+			}
+		}
+		return k;
+	}
+
+	/**
+	 * Compares a block of 4 left elements against a block of 4 right elements with 4 compares (the right block
+	 * rotated by one lane each time), then advances the block with the smaller last element, or both on a tie.
+	 * Every left element meets every right element that could be equal to it exactly once
+	 */
+	inline uint32_t BlockMatches(const uint32_t* left, const uint32_t* right)
+	{
+		const __m128i leftBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left));
+		const __m128i rightBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right));
+		const __m128i matches = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi32(leftBlock, rightBlock), _mm_cmpeq_epi32(leftBlock, _mm_shuffle_epi32(rightBlock, _MM_SHUFFLE(0, 3, 2, 1)))),
+			_mm_or_si128(_mm_cmpeq_epi32(leftBlock, _mm_shuffle_epi32(rightBlock, _MM_SHUFFLE(1, 0, 3, 2))), _mm_cmpeq_epi32(leftBlock, _mm_shuffle_epi32(rightBlock, _MM_SHUFFLE(2, 1, 0, 3)))));
+		return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(matches)));
+	}
+
+	template <typename T>
+	size_t Intersect(const T* left, size_t leftCount, const T* right, size_t rightCount, T* target, std::false_type)
+	{
+		return IntersectMerge(left, leftCount, right, rightCount, target);
+	}
+
+	template <typename T>
+	size_t Intersect(const T* left, size_t leftCount, const T* right, size_t rightCount, T* target, std::true_type)
+	{
+		const uint32_t* const leftKeys = reinterpret_cast<const uint32_t*>(left);
+		const uint32_t* const rightKeys = reinterpret_cast<const uint32_t*>(right);
+		size_t i = 0u;
+		size_t j = 0u;
+		size_t k = 0u;
+		while (i + 4u <= leftCount && j + 4u <= rightCount)
+		{
+			uint32_t matches = BlockMatches(leftKeys + i, rightKeys + j);
+			while (matches != 0u)
+			{
+				target[k++] = left[i + Simd::LowestSetBit(matches)];
+				matches &= matches - 1u;
+			}
+			const T leftLast = left[i + 3u];
+			const T rightLast = right[j + 3u];
+			i += leftLast < rightLast || leftLast == rightLast ? 4u : 0u;
+			j += rightLast < leftLast || leftLast == rightLast ? 4u : 0u;
+		}
+		// Elements matched so far lie before i and j, the rest is merged
+		return k + IntersectMerge(left + i, leftCount - i, right + j, rightCount - j, target + k);
+	}
+
+	template <typename T>
+	size_t Difference(const T* left, size_t leftCount, const T* right, size_t rightCount, T* target, std::false_type)
+	{
+		return DifferenceMerge(left, leftCount, right, rightCount, target);
+	}
+
+	/**
+	 * Like Intersect, but the matches of the current left block are collected until the block advances, then its
+	 * unmatched elements are written
+	 */
+	template <typename T>
+	size_t Difference(const T* left, size_t leftCount, const T* right, size_t rightCount, T* target, std::true_type)
+	{
+		const uint32_t* const leftKeys = reinterpret_cast<const uint32_t*>(left);
+		const uint32_t* const rightKeys = reinterpret_cast<const uint32_t*>(right);
+		size_t i = 0u;
+		size_t j = 0u;
+		size_t k = 0u;
+		uint32_t blockMatches = 0u;
+		while (i + 4u <= leftCount && j + 4u <= rightCount)
+		{
+			blockMatches |= BlockMatches(leftKeys + i, rightKeys + j);
+			const T leftLast = left[i + 3u];
+			const T rightLast = right[j + 3u];
+			if (rightLast < leftLast || leftLast == rightLast)
+			{
+				j += 4u;
+			}
+			if (leftLast < rightLast || leftLast == rightLast)
+			{
+				uint32_t missing = ~blockMatches & 0xFu;
+				while (missing != 0u)
+				{
+					target[k++] = left[i + Simd::LowestSetBit(missing)];
+					missing &= missing - 1u;
+				}
+				blockMatches = 0u;
+				i += 4u;
+			}
+		}
+
+		// The right side ran out in the middle of a left block, its unmatched elements still have to be merged
+		if (blockMatches != 0u)
+		{
+			for (size_t lane = 0u; lane < 4u; ++lane, ++i)
+			{
+				if (blockMatches & (1u << lane))
+				{
+					continue;
+				}
+				while (j < rightCount && right[j] < left[i])
+				{
+					++j;
+				}
+				if (j == rightCount || left[i] < right[j])
+				{
+					target[k++] = left[i];
+				}
+			}
+		}
+		return k + DifferenceMerge(left + i, leftCount - i, right + j, rightCount - j, target + k);
+	}
+
+	template <typename T>
+	struct IsBlockComparable : std::integral_constant<bool, std::is_integral<T>::value && sizeof(T) == 4u> {};
+
+	template <typename T>
+	void CheckInputs(const Vector<T>& left, const Vector<T>& right, const Vector<T>& target)
+	{
+		assert("Set operation input is not sorted or has duplicates" && IsStrictlySorted(left) && IsStrictlySorted(right));
+		{ const bool isAliased = &target == &left || &target == &right; assert("Set operation target aliases an input" && !isAliased); }
+	}
+}
+
+/**
+ * set_intersection / set_union / set_difference write the elements in both / either / only the left of two vectors
+ * sorted ascending without duplicates to target, which is grown once up front and then shrunk to the result.
+ * Intersection and difference of 32 bit integers compare blocks of 4 x 4 elements with SSE2, inputs of very different
+ * sizes gallop through the larger one. T has to be trivially copyable (see resize_uninitialized)
+ */
+template <typename T>
+void set_intersection(const Vector<T>& left, const Vector<T>& right, Vector<T>& target)
+{
+	SetOperations::CheckInputs(left, right, target);
+	const size_t leftCount = left.size();
+	const size_t rightCount = right.size();
+	target.resize_uninitialized(leftCount < rightCount ? leftCount : rightCount);
+
+	size_t count;
+	if (leftCount * SetOperations::GALLOPING_RATIO <= rightCount)
+	{
+		count = SetOperations::IntersectGalloping(left.data(), leftCount, right.data(), rightCount, target.data());
+	}
+	else if (rightCount * SetOperations::GALLOPING_RATIO <= leftCount)
+	{
+		count = SetOperations::IntersectGalloping(right.data(), rightCount, left.data(), leftCount, target.data());
+	}
+	else
+	{
+		count = SetOperations::Intersect(left.data(), leftCount, right.data(), rightCount, target.data(), SetOperations::IsBlockComparable<T>());
+	}
+	target.resize_uninitialized(count);
+}
+
+template <typename T>
+void set_union(const Vector<T>& left, const Vector<T>& right, Vector<T>& target)
+{
+	SetOperations::CheckInputs(left, right, target);
+	target.resize_uninitialized(left.size() + right.size());
+	const size_t count = SetOperations::UnionMerge(left.data(), left.size(), right.data(), right.size(), target.data());
+	target.resize_uninitialized(count);
+}
+
+template <typename T>
+void set_difference(const Vector<T>& left, const Vector<T>& right, Vector<T>& target)
+{
+	SetOperations::CheckInputs(left, right, target);
+	const size_t leftCount = left.size();
+	const size_t rightCount = right.size();
+	target.resize_uninitialized(leftCount);
+
+	size_t count;
+	if (leftCount * SetOperations::GALLOPING_RATIO <= rightCount)
+	{
+		count = SetOperations::DifferenceGalloping(left.data(), leftCount, right.data(), rightCount, target.data());
+	}
+	else
+	{
+		count = SetOperations::Difference(left.data(), leftCount, right.data(), rightCount, target.data(), SetOperations::IsBlockComparable<T>());
+	}
+	target.resize_uninitialized(count);
+}
+
+/**
+ * ConcurrentVector is a multi-producer append-only container built on the same idea as Vector<T>: the whole address
+ * space is reserved up front, so elements never move and references to them are never invalidated.
+ * - push_back claims its slot with a single atomic fetch-add on the size, there is no lock on the fast path
+ * - Physical memory is only committed when a claimed slot lies behind the committed end. Only then the committing
+ *   threads serialize on a mutex, everybody else keeps appending into the already committed pages
+ * - Elements are only safe to read from other threads after the producers are synchronized with the readers
+ *   (e.g. joined), size() counts claimed slots which might still be under construction
+ * The only shared write on the fast path is the fetch-add, so producers that append in bulk should use grow_by()
+ * to claim a whole range at once
+ */
+template <typename T>
+class ConcurrentVector
+{
+	union PointerType
+	{
+		void* as_void;
+		uintptr_t as_ptr;
+		T* as_element;
+	};
+
+public:
+	ConcurrentVector(void);
+	~ConcurrentVector(void);
+
+	size_t size(void) const;
+	size_t capacity(void) const;
+
+	size_t push_back(const T& object);
+	size_t grow_by(size_t count, const T& object);
+
+	T& operator[] (size_t index);
+	const T& operator[] (size_t index) const;
+
+private:
+	ConcurrentVector(const ConcurrentVector<T>& other) = delete;
+	ConcurrentVector<T>& operator=(const ConcurrentVector<T>& other) = delete;
+
+	size_t ClaimSlots(size_t count);
+	void CommitUpTo(uintptr_t requiredEnd);
+	size_t GetMaxElements(void) const;
+
+	// The size is hammered by all producers, the committed end is read by all of them. Both get their own
+	// cache line so the claims don't invalidate the line every producer checks the committed end on
+	alignas(64) std::atomic<size_t> m_size;
+	alignas(64) std::atomic<uintptr_t> m_physical_mem_end;
+	std::mutex m_commitMutex;
+	size_t m_pageSize;
+
+	PointerType m_virtual_mem_begin;
+	PointerType m_virtual_mem_end;
+
+	//Same maximum as Vector<T> - 1GB
+	static const size_t MAX_VECTOR_CAPACITY = 1024 * 1024 * 1024;
+};
+
+template <typename T>
+ConcurrentVector<T>::ConcurrentVector()
+	: m_size(0u)
+	, m_physical_mem_end(0u)
+	, m_pageSize(VirtualMemory::GetPageSize())
+	, m_virtual_mem_begin { VirtualMemory::ReserveAddressSpace(MAX_VECTOR_CAPACITY) }
+	, m_virtual_mem_end { reinterpret_cast<void*>(m_virtual_mem_begin.as_ptr + MAX_VECTOR_CAPACITY) }
+{
+	m_physical_mem_end.store(m_virtual_mem_begin.as_ptr);
+}
+
+/**
+ * The destructor expects all producers to be done (it is not safe to destroy the container while someone appends)
+ */
+template <typename T>
+ConcurrentVector<T>::~ConcurrentVector()
+{
+	const size_t size = m_size.load();
+	for (size_t i = 0u; i < size; ++i)
+	{
+		m_virtual_mem_begin.as_element[i].~T();
+	}
+	VirtualMemory::FreeAddressSpace(m_virtual_mem_begin.as_void);
+}
+
+template <typename T>
+size_t ConcurrentVector<T>::size() const
+{
+	return m_size.load(std::memory_order_acquire);
+}
+
+template <typename T>
+size_t ConcurrentVector<T>::capacity() const
+{
+	return (m_physical_mem_end.load(std::memory_order_acquire) - m_virtual_mem_begin.as_ptr) / sizeof(T);
+}
+
+/**
+ * Appends a copy of object and returns the index it was stored at. Safe to call from any number of threads
+ */
+template <typename T>
+size_t ConcurrentVector<T>::push_back(const T& object)
+{
+	const size_t index = ClaimSlots(1u);
+	new (m_virtual_mem_begin.as_element + index) T(object);
+	return index;
+}
+
+/**
+ * Appends count copies of object as one contiguous range and returns the index of the first one.
+ * The whole range is claimed with a single fetch-add
+ */
+template <typename T>
+size_t ConcurrentVector<T>::grow_by(size_t count, const T& object)
+{
+	const size_t firstIndex = ClaimSlots(count);
+	for (size_t i = firstIndex; i < firstIndex + count; ++i)
+	{
+		new (m_virtual_mem_begin.as_element + i) T(object);
+	}
+	return firstIndex;
+}
+
+template <typename T>
+T& ConcurrentVector<T>::operator[](size_t index)
+{
+	//No check for >= 0 needed because index is unsigned!
+	assert("Subscript out of range!" && index < m_size.load(std::memory_order_relaxed));
+	return m_virtual_mem_begin.as_element[index];
+}
+
+template <typename T>
+const T& ConcurrentVector<T>::operator[](size_t index) const
+{
+	//No check for >= 0 needed because index is unsigned!
+	assert("Subscript out of range!" && index < m_size.load(std::memory_order_relaxed));
+	return m_virtual_mem_begin.as_element[index];
+}
+
+/**
+ * Claims count slots and makes sure their memory is committed. The committed end only ever grows, so if our slots
+ * are in front of it we can go on without touching the mutex
+ */
+template <typename T>
+size_t ConcurrentVector<T>::ClaimSlots(size_t count)
+{
+	const size_t firstIndex = m_size.fetch_add(count, std::memory_order_relaxed);
+	{
+		const bool claimExceedsAvailableRange = firstIndex + count > GetMaxElements();
+		assert("Grow would exceed maximum available address space - cannot grow further!" && !claimExceedsAvailableRange);
+	}
+
+	const uintptr_t requiredEnd = m_virtual_mem_begin.as_ptr + (firstIndex + count) * sizeof(T);
+	if (requiredEnd > m_physical_mem_end.load(std::memory_order_acquire))
+	{
+		CommitUpTo(requiredEnd);
+	}
+	return firstIndex;
+}
+
+/**
+ * CommitUpTo is the concurrent counterpart of Vector<T>::GrowByBytes. The first thread that gets the mutex commits
+ * for everybody waiting: it at least doubles the committed memory (same policy as the vector), so the threads queued
+ * behind it usually find their slots committed already and leave without a system call
+ */
+template <typename T>
+void ConcurrentVector<T>::CommitUpTo(uintptr_t requiredEnd)
+{
+	std::lock_guard<std::mutex> lock(m_commitMutex);
+
+	const uintptr_t committedEnd = m_physical_mem_end.load(std::memory_order_relaxed);
+	if (requiredEnd <= committedEnd)
+	{
+		return;
+	}
+
+	const size_t committedBytes = committedEnd - m_virtual_mem_begin.as_ptr;
+	const size_t requiredBytes = requiredEnd - committedEnd;
+	size_t growSizeInBytes = MathUtil::roundUpToMultiple(requiredBytes > committedBytes ? requiredBytes : committedBytes, m_pageSize);
+	if (committedEnd + growSizeInBytes > m_virtual_mem_end.as_ptr)
+	{
+		growSizeInBytes = m_virtual_mem_end.as_ptr - committedEnd;
+	}
+
+	VirtualMemory::GetPhysicalMemory(reinterpret_cast<void*>(committedEnd), growSizeInBytes);
+	m_physical_mem_end.store(committedEnd + growSizeInBytes, std::memory_order_release);
+}
+
+template <typename T>
+size_t ConcurrentVector<T>::GetMaxElements(void) const
+{
+	return MAX_VECTOR_CAPACITY / sizeof(T);
+}
+
+/**
+ * PublishingVector supports one writer thread appending while any number of reader threads scan the content without
+ * any lock. It works because the memory never moves and committed pages are never decommitted while the vector lives:
+ * - The writer constructs the new element and then publishes it with a release-store of the size
+ * - A reader takes a ReadView, which acquire-loads the size once. Every element in front of that size is fully
+ *   constructed and visible, and stays where it is for the lifetime of the view
+ * Shrinking is the only operation that could pull elements from under a reader, so there is no erase at all and
+ * clear() is fenced by epochs: every non-empty view registers with the epoch it was taken in, clear() publishes the
+ * empty state, starts a new epoch and only waits for the views of the previous one before it destroys the elements.
+ * Views taken after the clear never hold it up, but a non-empty view of the old elements held by the writer thread
+ * itself would wait forever
+ */
+template <typename T>
+class PublishingVector
+{
+	union PointerType
+	{
+		void* as_void;
+		uintptr_t as_ptr;
+		T* as_element;
+	};
+
+public:
+	/**
+	 * ReadView is a snapshot of the published elements. Creating, copying and destroying a view are single atomic
+	 * increments / decrements, reading through the view needs no synchronization at all
+	 */
+	class ReadView
+	{
+	public:
+		ReadView(const ReadView& other);
+		~ReadView(void);
+
+		size_t size(void) const;
+		bool empty(void) const;
+
+		const T& operator[] (size_t index) const;
+		const T* begin(void) const;
+		const T* end(void) const;
+
+	private:
+		friend class PublishingVector<T>;
+		explicit ReadView(const PublishingVector<T>& owner);
+		ReadView& operator=(const ReadView& other) = delete;
+
+		static const size_t UNREGISTERED = ~static_cast<size_t>(0u);
+
+		const PublishingVector<T>* m_owner;
+		const T* m_elements;
+		size_t m_size;
+		// Reader slot of the epoch the view registered in, UNREGISTERED for empty views
+		size_t m_slot;
+	};
+
+	PublishingVector(void);
+	~PublishingVector(void);
+
+	// Writer side, only one thread at a time
+	void push_back(const T& object);
+	void clear(void);
+
+	// Reader side, any thread
+	size_t size(void) const;
+	ReadView view(void) const;
+
+private:
+	PublishingVector(const PublishingVector<T>& other) = delete;
+	PublishingVector<T>& operator=(const PublishingVector<T>& other) = delete;
+
+	void GrowByBytes(size_t growSizeInBytes);
+	size_t GetMaxElements(void) const;
+
+	alignas(64) std::atomic<size_t> m_publishedSize;
+	alignas(64) std::atomic<size_t> m_epoch;
+	// Live views per epoch parity. clear() drains the previous epoch before it starts another, so two slots suffice
+	alignas(64) mutable std::atomic<size_t> m_activeReaders[2];
+
+	// Only touched by the writer
+	alignas(64) size_t m_capacity;
+	size_t m_pageSize;
+
+	PointerType m_virtual_mem_begin;
+	PointerType m_virtual_mem_end;
+	PointerType m_physical_mem_end;
+
+	//Same maximum as Vector<T> - 1GB
+	static const size_t MAX_VECTOR_CAPACITY = 1024 * 1024 * 1024;
+};
+
+/**
+ * The view registers in the slot of the current epoch and checks that the epoch did not change meanwhile, only then
+ * it loads the size. clear() stores the size before it starts the next epoch and checks the slot of the old one
+ * afterwards. With sequentially consistent ordering a view that registered in the old epoch is seen by clear(), and
+ * a view that registered in the new epoch sees the cleared size.
+ * An empty view can never touch an element, it drops its registration right away
+ */
+template <typename T>
+PublishingVector<T>::ReadView::ReadView(const PublishingVector<T>& owner)
+	: m_owner(&owner)
+	, m_elements(owner.m_virtual_mem_begin.as_element)
+	, m_size(0u)
+	, m_slot(UNREGISTERED)
+{
+	for (;;)
+	{
+		const size_t epoch = m_owner->m_epoch.load();
+		m_owner->m_activeReaders[epoch & 1u].fetch_add(1u);
+		if (m_owner->m_epoch.load() == epoch)
+		{
+			m_slot = epoch & 1u;
+			break;
+		}
+		m_owner->m_activeReaders[epoch & 1u].fetch_sub(1u);
+	}
+
+	m_size = m_owner->m_publishedSize.load();
+	if (m_size == 0u)
+	{
+		m_owner->m_activeReaders[m_slot].fetch_sub(1u, std::memory_order_release);
+		m_slot = UNREGISTERED;
+	}
+}
+
+/**
+ * The copy joins the epoch of other, which is still registered and keeps clear() waiting anyway
+ */
+template <typename T>
+PublishingVector<T>::ReadView::ReadView(const ReadView& other)
+	: m_owner(other.m_owner)
+	, m_elements(other.m_elements)
+	, m_size(other.m_size)
+	, m_slot(other.m_slot)
+{
+	if (m_slot != UNREGISTERED)
+	{
+		m_owner->m_activeReaders[m_slot].fetch_add(1u);
+	}
+}
+
+template <typename T>
+PublishingVector<T>::ReadView::~ReadView()
+{
+	if (m_slot != UNREGISTERED)
+	{
+		m_owner->m_activeReaders[m_slot].fetch_sub(1u, std::memory_order_release);
+	}
+}
+
+template <typename T>
+size_t PublishingVector<T>::ReadView::size() const
+{
+	return m_size;
+}
+
+template <typename T>
+bool PublishingVector<T>::ReadView::empty() const
+{
+	return m_size == 0u;
+}
+
+template <typename T>
+const T& PublishingVector<T>::ReadView::operator[](size_t index) const
+{
+	//No check for >= 0 needed because index is unsigned!
+	assert("Subscript out of range!" && index < m_size);
+	return m_elements[index];
+}
+
+template <typename T>
+const T* PublishingVector<T>::ReadView::begin() const
+{
+	return m_elements;
+}
+
+template <typename T>
+const T* PublishingVector<T>::ReadView::end() const
+{
+	return m_elements + m_size;
+}
+
+template <typename T>
+PublishingVector<T>::PublishingVector()
+	: m_publishedSize(0u)
+	, m_epoch(0u)
+	, m_capacity(0u)
+	, m_pageSize(VirtualMemory::GetPageSize())
+	, m_virtual_mem_begin { VirtualMemory::ReserveAddressSpace(MAX_VECTOR_CAPACITY) }
+	, m_virtual_mem_end { reinterpret_cast<void*>(m_virtual_mem_begin.as_ptr + MAX_VECTOR_CAPACITY) }
+	, m_physical_mem_end { m_virtual_mem_begin }
+{
+	m_activeReaders[0].store(0u);
+	m_activeReaders[1].store(0u);
+}
+
+template <typename T>
+PublishingVector<T>::~PublishingVector()
+{
+	assert("PublishingVector destroyed while ReadViews are alive!" && m_activeReaders[0].load() + m_activeReaders[1].load() == 0u);
+
+	const size_t size = m_publishedSize.load(std::memory_order_relaxed);
+	for (size_t i = 0u; i < size; ++i)
+	{
+		m_virtual_mem_begin.as_element[i].~T();
+	}
+	VirtualMemory::FreeAddressSpace(m_virtual_mem_begin.as_void);
+}
+
+/**
+ * The element is constructed first and published afterwards, a reader can never see a half constructed element.
+ * Growing only commits pages behind the published range, so readers are not affected by it either
+ */
+template <typename T>
+void PublishingVector<T>::push_back(const T& object)
+{
+	const size_t size = m_publishedSize.load(std::memory_order_relaxed);
+	if (m_capacity == size)
+	{
+		GrowByBytes((m_capacity ? m_capacity * 2 : 8) * sizeof(T));
+	}
+
+	new (m_virtual_mem_begin.as_element + size) T(object);
+	m_publishedSize.store(size + 1u, std::memory_order_release);
+}
+
+/**
+ * Publishes the empty vector, starts the next epoch, waits for the views of the previous epoch (the only ones that
+ * might still see the old elements) and destroys the elements afterwards.
+ * The committed pages are kept, just like Vector<T> keeps its capacity
+ */
+template <typename T>
+void PublishingVector<T>::clear()
+{
+	const size_t oldSize = m_publishedSize.load(std::memory_order_relaxed);
+	m_publishedSize.store(0u);
+
+	const size_t oldEpoch = m_epoch.load(std::memory_order_relaxed);
+	m_epoch.store(oldEpoch + 1u);
+	while (m_activeReaders[oldEpoch & 1u].load() != 0u)
+	{
+		std::this_thread::yield();
+	}
+
+	for (size_t i = 0u; i < oldSize; ++i)
+	{
+		m_virtual_mem_begin.as_element[i].~T();
+	}
+}
+
+template <typename T>
+size_t PublishingVector<T>::size() const
+{
+	return m_publishedSize.load(std::memory_order_acquire);
+}
+
+template <typename T>
+typename PublishingVector<T>::ReadView PublishingVector<T>::view() const
+{
+	return ReadView(*this);
+}
+
+/**
+ * Same grow behaviour as Vector<T>::GrowByBytes, only called by the writer
+ */
+template <typename T>
+void PublishingVector<T>::GrowByBytes(size_t growSizeInBytes)
+{
+	size_t roundedGrowSize = MathUtil::roundUpToMultiple(growSizeInBytes, m_pageSize);
+
+	{
+		const bool addressSpaceEndReached = m_physical_mem_end.as_ptr == m_virtual_mem_end.as_ptr;
+		assert("Grow would exceed maximum available address space - cannot grow further!" && !addressSpaceEndReached);
+	}
+
+	if (m_physical_mem_end.as_ptr + roundedGrowSize > m_virtual_mem_end.as_ptr)
+	{
+		roundedGrowSize = m_virtual_mem_end.as_ptr - m_physical_mem_end.as_ptr;
+	}
+
+	VirtualMemory::GetPhysicalMemory(m_physical_mem_end.as_void, roundedGrowSize);
+	m_physical_mem_end.as_ptr += roundedGrowSize;
+	m_capacity = (m_physical_mem_end.as_ptr - m_virtual_mem_begin.as_ptr) / sizeof(T);
+}
+
+template <typename T>
+size_t PublishingVector<T>::GetMaxElements(void) const
+{
+	return MAX_VECTOR_CAPACITY / sizeof(T);
+}
+
+/**
+ * ShardedVector gives every producer thread its own Vector<T> shard, so parallel ingestion needs no lock and no
+ * atomic at all: thread i only ever appends to shard(i). Every shard is a full Vector<T> with its own address space
+ * reservation and the shards are padded to separate cache lines, so producers don't even share the size counters.
+ * The content can be iterated across all shards with for_each or merged into one contiguous Vector<T> with merge_into
+ */
+template <typename T>
+class ShardedVector
+{
+public:
+	explicit ShardedVector(size_t shardCount);
+
+	size_t shard_count(void) const;
+	size_t size(void) const;
+
+	Vector<T>& shard(size_t index);
+	const Vector<T>& shard(size_t index) const;
+
+	template <typename Function>
+	void for_each(Function function) const;
+
+	void merge_into(Vector<T>& destination) const;
+
+private:
+	ShardedVector(const ShardedVector<T>& other) = delete;
+	ShardedVector<T>& operator=(const ShardedVector<T>& other) = delete;
+
+	void MergeInto(Vector<T>& destination, std::true_type isBitwiseCopyable) const;
+	void MergeInto(Vector<T>& destination, std::false_type isBitwiseCopyable) const;
+
+	struct alignas(64) Shard
+	{
+		Vector<T> elements;
+	};
+
+	Vector<Shard> m_shards;
+};
+
+template <typename T>
+ShardedVector<T>::ShardedVector(size_t shardCount)
+{
+	assert("A ShardedVector needs at least one shard" && shardCount != 0u);
+	m_shards.resize(shardCount);
+}
+
+template <typename T>
+size_t ShardedVector<T>::shard_count() const
+{
+	return m_shards.size();
+}
+
+/**
+ * Total amount of elements in all shards. Only meaningful while no producer appends
+ */
+template <typename T>
+size_t ShardedVector<T>::size() const
+{
+	size_t size = 0u;
+	for (const Shard& shard : m_shards)
+	{
+		size += shard.elements.size();
+	}
+	return size;
+}
+
+template <typename T>
+Vector<T>& ShardedVector<T>::shard(size_t index)
+{
+	return m_shards[index].elements;
+}
+
+template <typename T>
+const Vector<T>& ShardedVector<T>::shard(size_t index) const
+{
+	return m_shards[index].elements;
+}
+
+/**
+ * Calls function for every element, shard by shard, without merging anything
+ */
+template <typename T>
+template <typename Function>
+void ShardedVector<T>::for_each(Function function) const
+{
+	for (const Shard& shard : m_shards)
+	{
+		for (const T& element : shard.elements)
+		{
+			function(element);
+		}
+	}
+}
+
+/**
+ * Appends the content of all shards (in shard order) to destination. The destination grows once for all shards.
+ * Types that can be copied bitwise are copied with one memcpy per shard, all shards in parallel
+ */
+template <typename T>
+void ShardedVector<T>::merge_into(Vector<T>& destination) const
+{
+	MergeInto(destination, std::integral_constant<bool, std::is_trivially_copyable<T>::value && std::is_trivially_default_constructible<T>::value>());
+}
+
+template <typename T>
+void ShardedVector<T>::MergeInto(Vector<T>& destination, std::true_type) const
+{
+	const size_t shardCount = m_shards.size();
+	Vector<size_t> offsets;
+	offsets.resize_uninitialized(shardCount);
+
+	size_t offset = destination.size();
+	for (size_t i = 0u; i < shardCount; ++i)
+	{
+		offsets[i] = offset;
+		offset += m_shards[i].elements.size();
+	}
+
+	destination.resize_uninitialized(offset);
+	T* const target = destination.data();
+	Parallel::ForEachBlock(shardCount, [this, target, &offsets](size_t shard)
+	{
+		const Vector<T>& elements = m_shards[shard].elements;
+		if (!elements.empty())
+		{
+			std::memcpy(target + offsets[shard], elements.data(), elements.size() * sizeof(T));
+		}
+	});
+}
+
+template <typename T>
+void ShardedVector<T>::MergeInto(Vector<T>& destination, std::false_type) const
+{
+	destination.reserve(destination.size() + size());
+	for (const Shard& shard : m_shards)
+	{
+		destination.insert(destination.size(), shard.elements.begin(), shard.elements.end());
+	}
+}
+
+/**
+ * SpscRingBuffer is a lock-free single-producer / single-consumer byte ring for passing messages between two threads.
+ * The buffer memory is mapped twice back to back (see VirtualMemory::MapMirroredMemory), so the free and the filled
+ * part of the ring are always one contiguous span, even if they wrap around the end of the buffer:
+ * - The producer asks for a writable span of at least n bytes with begin_write, writes (or builds its message in place) and publishes
+ *   the bytes with commit_write. The consumer does the same with begin_read / commit_read
+ * - Read and write index only ever grow, the position in the buffer is the index masked with capacity - 1
+ * - Each side keeps a private copy of the other side's index and only reloads it if the cached one says the ring
+ *   is full (or empty), so the shared cache lines are not touched for every message
+ */
+class SpscRingBuffer
+{
+public:
+	explicit SpscRingBuffer(size_t minCapacityInBytes);
+	~SpscRingBuffer(void);
+
+	size_t capacity(void) const;
+
+	// Producer side
+	void* begin_write(size_t minBytes, size_t& writableBytes);
+	void commit_write(size_t writtenBytes);
+	bool try_write(const void* data, size_t sizeInBytes);
+
+	// Consumer side
+	const void* begin_read(size_t minBytes, size_t& readableBytes);
+	void commit_read(size_t readBytes);
+	bool try_read(void* data, size_t sizeInBytes);
+
+private:
+	SpscRingBuffer(const SpscRingBuffer& other) = delete;
+	SpscRingBuffer& operator=(const SpscRingBuffer& other) = delete;
+
+	// Producer owned cache line
+	alignas(64) std::atomic<size_t> m_writeIndex;
+	size_t m_cachedReadIndex;
+
+	// Consumer owned cache line
+	alignas(64) std::atomic<size_t> m_readIndex;
+	size_t m_cachedWriteIndex;
+
+	// Read only after construction
+	alignas(64) uint8_t* m_buffer;
+	size_t m_capacity;
+	HANDLE m_mapping;
+};
+
+/**
+ * The capacity is rounded up to a power of two (at least the allocation granularity), so the position in the ring
+ * is a simple mask of the index
+ */
+SpscRingBuffer::SpscRingBuffer(size_t minCapacityInBytes)
+	: m_writeIndex(0u)
+	, m_cachedReadIndex(0u)
+	, m_readIndex(0u)
+	, m_cachedWriteIndex(0u)
+	, m_buffer(nullptr)
+	, m_capacity(VirtualMemory::GetAllocationGranularity())
+	, m_mapping(nullptr)
+{
+	while (m_capacity < minCapacityInBytes)
+	{
+		m_capacity *= 2u;
+	}
+
+	m_buffer = static_cast<uint8_t*>(VirtualMemory::MapMirroredMemory(m_capacity, m_mapping));
+	assert("Could not map the mirrored ring buffer memory!" && m_buffer != nullptr);
+}
+
+SpscRingBuffer::~SpscRingBuffer()
+{
+	VirtualMemory::FreeMirroredMemory(m_buffer, m_capacity, m_mapping);
+}
+
+size_t SpscRingBuffer::capacity() const
+{
+	return m_capacity;
+}
+
+/**
+ * Returns the start of the contiguous free span and its size in writableBytes, or nullptr if less than minBytes are
+ * free. The consumer's index is only reloaded if the cached one does not leave minBytes free
+ */
+void* SpscRingBuffer::begin_write(size_t minBytes, size_t& writableBytes)
+{
+	const size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+	writableBytes = m_capacity - (writeIndex - m_cachedReadIndex);
+	if (writableBytes < minBytes)
+	{
+		m_cachedReadIndex = m_readIndex.load(std::memory_order_acquire);
+		writableBytes = m_capacity - (writeIndex - m_cachedReadIndex);
+		if (writableBytes < minBytes)
+		{
+			return nullptr;
+		}
+	}
+
+	return m_buffer + (writeIndex & (m_capacity - 1u));
+}
+
+/**
+ * Publishes writtenBytes bytes of the span returned by the last begin_write to the consumer
+ */
+void SpscRingBuffer::commit_write(size_t writtenBytes)
+{
+	const size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+	assert("Committed more bytes than the ring had free" && writeIndex + writtenBytes - m_cachedReadIndex <= m_capacity);
+	m_writeIndex.store(writeIndex + writtenBytes, std::memory_order_release);
+}
+
+/**
+ * Copies the whole message into the ring or nothing at all if there is not enough free space
+ */
+bool SpscRingBuffer::try_write(const void* data, size_t sizeInBytes)
+{
+	size_t writableBytes;
+	void* target = begin_write(sizeInBytes, writableBytes);
+	if (target == nullptr)
+	{
+		return false;
+	}
+
+	std::memcpy(target, data, sizeInBytes);
+	commit_write(sizeInBytes);
+	return true;
+}
+
+/**
+ * Returns the start of the contiguous filled span and its size in readableBytes, or nullptr if less than minBytes
+ * are filled. The producer's index is only reloaded if the cached one does not cover minBytes
+ */
+const void* SpscRingBuffer::begin_read(size_t minBytes, size_t& readableBytes)
+{
+	const size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+	readableBytes = m_cachedWriteIndex - readIndex;
+	if (readableBytes < minBytes || readableBytes == 0u)
+	{
+		m_cachedWriteIndex = m_writeIndex.load(std::memory_order_acquire);
+		readableBytes = m_cachedWriteIndex - readIndex;
+		if (readableBytes < minBytes)
+		{
+			return nullptr;
+		}
+	}
+
+	return m_buffer + (readIndex & (m_capacity - 1u));
+}
+
+/**
+ * Hands readBytes bytes of the span returned by the last begin_read back to the producer
+ */
+void SpscRingBuffer::commit_read(size_t readBytes)
+{
+	const size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+	assert("Committed more bytes than the ring had filled" && readIndex + readBytes <= m_cachedWriteIndex);
+	m_readIndex.store(readIndex + readBytes, std::memory_order_release);
+}
+
+/**
+ * Copies a whole message of sizeInBytes out of the ring or nothing at all if not enough bytes are filled yet
+ */
+bool SpscRingBuffer::try_read(void* data, size_t sizeInBytes)
+{
+	size_t readableBytes;
+	const void* source = begin_read(sizeInBytes, readableBytes);
+	if (source == nullptr)
+	{
+		return false;
+	}
+
+	std::memcpy(data, source, sizeInBytes);
+	commit_read(sizeInBytes);
+	return true;
+}
+
+/**
+ * FlatStorage namespace holds the search and merge helpers FlatSet and FlatMap share
+ */
+namespace FlatStorage
+{
+	/**
+	 * Returns the index of the first key that is not smaller than key. The loop has a fixed trip count of log2(count)
+	 * and picks the next half with a conditional move instead of a branch, so there is nothing to mispredict.
+	 * Both possible next midpoints are prefetched, which hides part of the cache misses on large key arrays
+	 */
+	template <typename K, typename Compare>
+	size_t BranchlessLowerBound(const K* keys, size_t count, const K& key, const Compare& compare)
+	{
+		if (count == 0u)
+		{
+			return 0u;
+		}
+
+		const K* base = keys;
+		size_t remaining = count;
+		while (remaining > 1u)
+		{
+			const size_t half = remaining / 2u;
+			CompilerHints::Prefetch(base + half / 2u);
+			CompilerHints::Prefetch(base + half + half / 2u);
+			base = compare(base[half], key) ? base + half : base;
+			remaining -= half;
+		}
+		return static_cast<size_t>(base - keys) + static_cast<size_t>(compare(*base, key));
+	}
+
+	/**
+	 * Lower bound of key in [rangeBegin, rangeEnd) that first doubles its step from rangeBegin, like
+	 * SetOperations::Gallop but ordered by compare. Cheap when consecutive searches land close to each other
+	 */
+	template <typename K, typename Compare>
+	size_t Gallop(const K* keys, size_t rangeBegin, size_t rangeEnd, const K& key, const Compare& compare)
+	{
+		size_t bound = 1u;
+		while (rangeBegin + bound < rangeEnd && compare(keys[rangeBegin + bound], key))
+		{
+			bound *= 2u;
+		}
+		const size_t searchBegin = rangeBegin + bound / 2u;
+		const size_t searchEnd = rangeBegin + bound + 1u < rangeEnd ? rangeBegin + bound + 1u : rangeEnd;
+		return searchBegin + BranchlessLowerBound(keys + searchBegin, searchEnd - searchBegin, key, compare);
+	}
+
+	/**
+	 * Sorts a batch of keys by position, stable, so the first occurrence of equal keys comes first
+	 */
+	template <typename K, typename Compare>
+	void SortedOrder(const Vector<K>& keys, const Compare& compare, Vector<size_t>& order)
+	{
+		order.resize_uninitialized(keys.size());
+		for (size_t i = 0u; i < keys.size(); ++i)
+		{
+			order[i] = i;
+		}
+		const K* const elements = keys.data();
+		parallel_sort(order, [elements, &compare](size_t a, size_t b)
+		{
+			return compare(elements[a], elements[b]) || (!compare(elements[b], elements[a]) && a < b);
+		});
+	}
+
+	/**
+	 * Drops every entry of order whose key equals the key of the entry before it, keeping the first occurrence
+	 */
+	template <typename K, typename Compare>
+	void UniqueOrder(const Vector<K>& keys, const Compare& compare, Vector<size_t>& order)
+	{
+		size_t uniqueCount = 0u;
+		for (size_t i = 0u; i < order.size(); ++i)
+		{
+			if (uniqueCount == 0u || compare(keys[order[uniqueCount - 1u]], keys[order[i]]))
+			{
+				order[uniqueCount++] = order[i];
+			}
+		}
+		order.resize(uniqueCount);
+	}
+
+	/**
+	 * Merges the batch entries in order (sorted, unique) into the sorted storage in one pass. The storage grows once
+	 * by the amount of new keys and is filled from the back, so existing entries move at most once and no temporary
+	 * array is needed. Keys that are already stored keep their entry. move(from, to) moves storage entry from to
+	 * index to, put(batchIndex, to) writes the batch entry to index to
+	 */
+	template <typename K, typename Compare, typename Resize, typename Move, typename Put>
+	void MergeBatch(const Vector<K>& storedKeys, const Vector<K>& batchKeys, const Vector<size_t>& order, const Compare& compare, Resize resize, Move move, Put put)
+	{
+		const size_t storedCount = storedKeys.size();
+		const size_t batchCount = order.size();
+
+		size_t newCount = 0u;
+		size_t position = 0u;
+		for (size_t j = 0u; j < batchCount; ++j)
+		{
+			const K& key = batchKeys[order[j]];
+			position = position < storedCount ? Gallop(storedKeys.data(), position, storedCount, key, compare) : storedCount;
+			newCount += static_cast<size_t>(position == storedCount || compare(key, storedKeys[position]));
+		}
+		if (newCount == 0u)
+		{
+			return;
+		}
+
+		resize(storedCount + newCount);
+		size_t i = storedCount;
+		size_t j = batchCount;
+		size_t target = storedCount + newCount;
+		while (j > 0u)
+		{
+			const K& key = batchKeys[order[j - 1u]];
+			if (i > 0u && compare(key, storedKeys[i - 1u]))
+			{
+				move(--i, --target);
+			}
+			else if (i > 0u && !compare(storedKeys[i - 1u], key))
+			{
+				--j;
+			}
+			else
+			{
+				put(order[--j], --target);
+			}
+		}
+	}
+}
+
+/**
+ * FlatSet stores unique keys sorted in one Vector<K>. Lookups are branchless binary searches over contiguous memory,
+ * which beats the pointer chasing of node based sets for read-mostly data. Single inserts / erases shift the tail,
+ * so larger amounts of keys should come in through build (sort once) or insert_batch (merge once)
+ */
+template <typename K, typename Compare = std::less<K>>
+class FlatSet
+{
+public:
+	typedef const K* const_iterator;
+
+	explicit FlatSet(const Compare& compare = Compare());
+
+	void build(const Vector<K>& keys);
+	bool insert(const K& key);
+	void insert_batch(const Vector<K>& keys);
+	bool erase(const K& key);
+	void clear(void);
+
+	bool contains(const K& key) const;
+	const_iterator find(const K& key) const;
+	size_t lower_bound(const K& key) const;
+
+	size_t size(void) const;
+	bool empty(void) const;
+	const Vector<K>& keys(void) const;
+	const_iterator begin(void) const;
+	const_iterator end(void) const;
+
+private:
+	FlatSet(const FlatSet& other) = delete;
+	FlatSet& operator=(const FlatSet& other) = delete;
+
+	Vector<K> m_keys;
+	Compare m_compare;
+};
+
+template <typename K, typename Compare>
+FlatSet<K, Compare>::FlatSet(const Compare& compare)
+	: m_compare(compare)
+{
+}
+
+/**
+ * Replaces the content with the given keys: copied as they are, sorted once in parallel and made unique
+ */
+template <typename K, typename Compare>
+void FlatSet<K, Compare>::build(const Vector<K>& keys)
+{
+	m_keys = keys;
+	parallel_sort(m_keys, m_compare);
+
+	const Compare& compare = m_compare;
+	const K* const uniqueEnd = std::unique(m_keys.begin(), m_keys.end(), [&compare](const K& a, const K& b) { return !compare(a, b); });
+	m_keys.resize(static_cast<size_t>(uniqueEnd - m_keys.begin()));
+}
+
+/**
+ * Returns false if the key was already in the set
+ */
+template <typename K, typename Compare>
+bool FlatSet<K, Compare>::insert(const K& key)
+{
+	const size_t index = lower_bound(key);
+	if (index < m_keys.size() && !m_compare(key, m_keys[index]))
+	{
+		return false;
+	}
+	m_keys.insert(index, key);
+	return true;
+}
+
+/**
+ * Inserts all keys at once: the batch is sorted, then merged into the set in one pass (see FlatStorage::MergeBatch)
+ */
+template <typename K, typename Compare>
+void FlatSet<K, Compare>::insert_batch(const Vector<K>& keys)
+{
+	Vector<size_t> order;
+	FlatStorage::SortedOrder(keys, m_compare, order);
+	FlatStorage::UniqueOrder(keys, m_compare, order);
+
+	K* storedKeys = nullptr;
+	FlatStorage::MergeBatch(m_keys, keys, order, m_compare,
+		[this, &storedKeys](size_t newSize) { m_keys.resize(newSize); storedKeys = m_keys.data(); },
+		[&storedKeys](size_t from, size_t to) { storedKeys[to] = std::move(storedKeys[from]); },
+		[&storedKeys, &keys](size_t batchIndex, size_t to) { storedKeys[to] = keys[batchIndex]; });
+}
+
+/**
+ * Returns false if the key was not in the set
+ */
+template <typename K, typename Compare>
+bool FlatSet<K, Compare>::erase(const K& key)
+{
+	const size_t index = lower_bound(key);
+	if (index == m_keys.size() || m_compare(key, m_keys[index]))
+	{
+		return false;
+	}
+	m_keys.erase(index);
+	return true;
+}
+
+template <typename K, typename Compare>
+void FlatSet<K, Compare>::clear()
+{
+	m_keys.resize(0u);
+}
+
+template <typename K, typename Compare>
+bool FlatSet<K, Compare>::contains(const K& key) const
+{
+	return find(key) != end();
+}
+
+template <typename K, typename Compare>
+typename FlatSet<K, Compare>::const_iterator FlatSet<K, Compare>::find(const K& key) const
+{
+	const size_t index = lower_bound(key);
+	return index < m_keys.size() && !m_compare(key, m_keys[index]) ? m_keys.begin() + index : end();
+}
+
+/**
+ * Index of the first key that is not smaller than key, size() if there is none
+ */
+template <typename K, typename Compare>
+size_t FlatSet<K, Compare>::lower_bound(const K& key) const
+{
+	return FlatStorage::BranchlessLowerBound(m_keys.data(), m_keys.size(), key, m_compare);
+}
+
+template <typename K, typename Compare>
+size_t FlatSet<K, Compare>::size() const
+{
+	return m_keys.size();
+}
+
+template <typename K, typename Compare>
+bool FlatSet<K, Compare>::empty() const
+{
+	return m_keys.empty();
+}
+
+template <typename K, typename Compare>
+const Vector<K>& FlatSet<K, Compare>::keys() const
+{
+	return m_keys;
+}
+
+template <typename K, typename Compare>
+typename FlatSet<K, Compare>::const_iterator FlatSet<K, Compare>::begin() const
+{
+	return m_keys.begin();
+}
+
+template <typename K, typename Compare>
+typename FlatSet<K, Compare>::const_iterator FlatSet<K, Compare>::end() const
+{
+	return m_keys.end();
+}
+
+/**
+ * FlatMap stores unique keys sorted in one Vector<K> and their values at the same index in a second Vector<V>.
+ * Searches only touch the dense key array, values are read once the index is known. Same insertion trade-offs as
+ * FlatSet: bulk data goes through build or insert_batch
+ */
+template <typename K, typename V, typename Compare = std::less<K>>
+class FlatMap
+{
+public:
+	explicit FlatMap(const Compare& compare = Compare());
+
+	void build(const Vector<K>& keys, const Vector<V>& values);
+	bool insert(const K& key, const V& value);
+	void insert_batch(const Vector<K>& keys, const Vector<V>& values);
+	bool erase(const K& key);
+	void clear(void);
+
+	V& operator[](const K& key);
+	V* find(const K& key);
+	const V* find(const K& key) const;
+	bool contains(const K& key) const;
+	size_t lower_bound(const K& key) const;
+
+	size_t size(void) const;
+	bool empty(void) const;
+	const Vector<K>& keys(void) const;
+	Vector<V>& values(void);
+	const Vector<V>& values(void) const;
+
+private:
+	FlatMap(const FlatMap& other) = delete;
+	FlatMap& operator=(const FlatMap& other) = delete;
+
+	Vector<K> m_keys;
+	Vector<V> m_values;
+	Compare m_compare;
+};
+
+template <typename K, typename V, typename Compare>
+FlatMap<K, V, Compare>::FlatMap(const Compare& compare)
+	: m_compare(compare)
+{
+}
+
+/**
+ * Replaces the content with the given key / value pairs. The pairs are sorted by key once, for equal keys the
+ * first pair wins
+ */
+template <typename K, typename V, typename Compare>
+void FlatMap<K, V, Compare>::build(const Vector<K>& keys, const Vector<V>& values)
+{
+	{ const bool isSizeEqual = keys.size() == values.size(); assert("FlatMap needs one value per key" && isSizeEqual); }
+	Vector<size_t> order;
+	FlatStorage::SortedOrder(keys, m_compare, order);
+	FlatStorage::UniqueOrder(keys, m_compare, order);
+	gather(keys, order, m_keys);
+	gather(values, order, m_values);
+}
+
+/**
+ * Returns false (and keeps the stored value) if the key was already in the map
+ */
+template <typename K, typename V, typename Compare>
+bool FlatMap<K, V, Compare>::insert(const K& key, const V& value)
+{
+	const size_t index = lower_bound(key);
+	if (index < m_keys.size() && !m_compare(key, m_keys[index]))
+	{
+		return false;
+	}
+	m_keys.insert(index, key);
+	m_values.insert(index, value);
+	return true;
+}
+
+/**
+ * Inserts all pairs at once like FlatSet::insert_batch. Stored keys keep their value, for equal keys in the batch
+ * the first pair wins
+ */
+template <typename K, typename V, typename Compare>
+void FlatMap<K, V, Compare>::insert_batch(const Vector<K>& keys, const Vector<V>& values)
+{
+	{ const bool isSizeEqual = keys.size() == values.size(); assert("FlatMap needs one value per key" && isSizeEqual); }
+	Vector<size_t> order;
+	FlatStorage::SortedOrder(keys, m_compare, order);
+	FlatStorage::UniqueOrder(keys, m_compare, order);
+
+	K* storedKeys = nullptr;
+	V* storedValues = nullptr;
+	FlatStorage::MergeBatch(m_keys, keys, order, m_compare,
+		[this, &storedKeys, &storedValues](size_t newSize)
+		{
+			m_keys.resize(newSize);
+			m_values.resize(newSize);
+			storedKeys = m_keys.data();
+			storedValues = m_values.data();
+		},
+		[&storedKeys, &storedValues](size_t from, size_t to)
+		{
+			storedKeys[to] = std::move(storedKeys[from]);
+			storedValues[to] = std::move(storedValues[from]);
+		},
+		[&storedKeys, &storedValues, &keys, &values](size_t batchIndex, size_t to)
+		{
+			storedKeys[to] = keys[batchIndex];
+			storedValues[to] = values[batchIndex];
+		});
+}
+
+/**
+ * Returns false if the key was not in the map
+ */
+template <typename K, typename V, typename Compare>
+bool FlatMap<K, V, Compare>::erase(const K& key)
+{
+	const size_t index = lower_bound(key);
+	if (index == m_keys.size() || m_compare(key, m_keys[index]))
+	{
+		return false;
+	}
+	m_keys.erase(index);
+	m_values.erase(index);
+	return true;
+}
+
+template <typename K, typename V, typename Compare>
+void FlatMap<K, V, Compare>::clear()
+{
+	m_keys.resize(0u);
+	m_values.resize(0u);
+}
+
+/**
+ * Returns the value of key, a default constructed value is inserted if the key is missing
+ */
+template <typename K, typename V, typename Compare>
+V& FlatMap<K, V, Compare>::operator[](const K& key)
+{
+	const size_t index = lower_bound(key);
+	if (index == m_keys.size() || m_compare(key, m_keys[index]))
+	{
+		m_keys.insert(index, key);
+		m_values.insert(index, V());
+	}
+	return m_values[index];
+}
+
+/**
+ * Returns the value of key or nullptr if the key is missing
+ */
+template <typename K, typename V, typename Compare>
+V* FlatMap<K, V, Compare>::find(const K& key)
+{
+	const size_t index = lower_bound(key);
+	return index < m_keys.size() && !m_compare(key, m_keys[index]) ? m_values.data() + index : nullptr;
+}
+
+template <typename K, typename V, typename Compare>
+const V* FlatMap<K, V, Compare>::find(const K& key) const
+{
+	const size_t index = lower_bound(key);
+	return index < m_keys.size() && !m_compare(key, m_keys[index]) ? m_values.data() + index : nullptr;
+}
+
+template <typename K, typename V, typename Compare>
+bool FlatMap<K, V, Compare>::contains(const K& key) const
+{
+	return find(key) != nullptr;
+}
+
+template <typename K, typename V, typename Compare>
+size_t FlatMap<K, V, Compare>::lower_bound(const K& key) const
+{
+	return FlatStorage::BranchlessLowerBound(m_keys.data(), m_keys.size(), key, m_compare);
+}
+
+template <typename K, typename V, typename Compare>
+size_t FlatMap<K, V, Compare>::size() const
+{
+	return m_keys.size();
+}
+
+template <typename K, typename V, typename Compare>
+bool FlatMap<K, V, Compare>::empty() const
+{
+	return m_keys.empty();
+}
+
+template <typename K, typename V, typename Compare>
+const Vector<K>& FlatMap<K, V, Compare>::keys() const
+{
+	return m_keys;
+}
+
+template <typename K, typename V, typename Compare>
+Vector<V>& FlatMap<K, V, Compare>::values()
+{
+	return m_values;
+}
+
+template <typename K, typename V, typename Compare>
+const Vector<V>& FlatMap<K, V, Compare>::values() const
+{
+	return m_values;
+}
+
+/**
+ * EytzingerIndex is a read-only search index over a sorted Vector<T>. It copies the keys into its own reservation in
+ * Eytzinger (BFS) order: the root at index 1, the children of node k at 2k and 2k + 1. A binary search then walks
+ * down from the front of the array, the top levels of the tree share a few hot cache lines, and the descendants
+ * a few levels down lie next to each other, so one prefetch covers a whole subtree level.
+ * Lookups return the rank of the lower bound in the original sorted vector, so the index can sit next to a sorted key
+ * column and its payload columns
+ */
+template <typename T, typename Compare = std::less<T>>
+class EytzingerIndex
+{
+public:
+	// Keys per cache line: the descendants of a node log2(LINE_ELEMENTS) levels down fill exactly one line
+	static const size_t LINE_ELEMENTS = sizeof(T) < 64u ? 64u / sizeof(T) : 1u;
+	// Lookups a batch walks down the tree in lockstep, their cache misses overlap
+	static const size_t BATCH_LANES = 8u;
+
+	explicit EytzingerIndex(const Compare& compare = Compare());
+
+	void build(const Vector<T>& sorted);
+
+	size_t lower_bound(const T& key) const;
+	void lower_bound_batch(const Vector<T>& keys, Vector<size_t>& ranks) const;
+	bool contains(const T& key) const;
+
+	size_t size(void) const;
+	bool empty(void) const;
+
+private:
+	EytzingerIndex(const EytzingerIndex& other) = delete;
+	EytzingerIndex& operator=(const EytzingerIndex& other) = delete;
+
+	static size_t FloorLog2(size_t value);
+
+	size_t Step(size_t node, const T& key) const;
+	size_t Finish(size_t node) const;
+	size_t SubtreeSize(size_t node) const;
+	size_t RankOf(size_t node) const;
+	void Fill(size_t node, const T* sorted, size_t& next);
+	void LowerBoundBatch(const T* keys, size_t* ranks, size_t count) const;
+
+	Vector<T> m_tree;
+	size_t m_count;
+	size_t m_height;
+	Compare m_compare;
+};
+
+template <typename T, typename Compare>
+EytzingerIndex<T, Compare>::EytzingerIndex(const Compare& compare)
+	: m_count(0u)
+	, m_height(0u)
+	, m_compare(compare)
+{
+}
+
+/**
+ * Rebuilds the index from sorted (ordered by Compare, duplicates allowed). Above a few MB the subtrees below the top
+ * levels fill in parallel, each subtree takes a contiguous range of the sorted keys
+ */
+template <typename T, typename Compare>
+void EytzingerIndex<T, Compare>::build(const Vector<T>& sorted)
+{
+	assert("EytzingerIndex needs sorted keys" && std::is_sorted(sorted.begin(), sorted.end(), m_compare));
+
+	m_count = sorted.size();
+	m_height = m_count != 0u ? FloorLog2(m_count) : 0u;
+	// Slot 0 stays unused, that keeps the children of every node on one cache line
+	m_tree.resize(m_count + 1u);
+	if (m_count == 0u)
+	{
+		return;
+	}
+
+	const T* const elements = sorted.data();
+	if (m_count * sizeof(T) < Simd::PARALLEL_SCAN_BYTES)
+	{
+		size_t next = 0u;
+		Fill(1u, elements, next);
+		return;
+	}
+
+	size_t splitDepth = 0u;
+	while ((static_cast<size_t>(1u) << splitDepth) < Parallel::ThreadPool::Instance().GetThreadCount() * 4u && splitDepth < m_height)
+	{
+		++splitDepth;
+	}
+	const size_t firstRoot = static_cast<size_t>(1u) << splitDepth;
+	for (size_t node = 1u; node < firstRoot; ++node)
+	{
+		m_tree[node] = elements[RankOf(node)];
+	}
+
+	const size_t lastRoot = (firstRoot * 2u - 1u) < m_count ? (firstRoot * 2u - 1u) : m_count;
+	Parallel::ForEachRange(lastRoot - firstRoot + 1u, 1u, [this, elements, firstRoot](size_t, size_t rangeBegin, size_t)
+	{
+		const size_t root = firstRoot + rangeBegin;
+		size_t next = RankOf(root) - SubtreeSize(root * 2u);
+		Fill(root, elements, next);
+	});
+}
+
+/**
+ * Returns the rank of the first key that is not smaller than key in the sorted vector, size() if there is none
+ */
+template <typename T, typename Compare>
+size_t EytzingerIndex<T, Compare>::lower_bound(const T& key) const
+{
+	size_t node = 1u;
+	while (node <= m_count)
+	{
+		node = Step(node, key);
+	}
+	return RankOf(Finish(node));
+}
+
+/**
+ * Looks up all keys and stores their ranks in ranks. Groups of BATCH_LANES keys walk the tree together, large batches
+ * are split across the ThreadPool
+ */
+template <typename T, typename Compare>
+void EytzingerIndex<T, Compare>::lower_bound_batch(const Vector<T>& keys, Vector<size_t>& ranks) const
+{
+	const size_t count = keys.size();
+	ranks.resize_uninitialized(count);
+	const T* const elements = keys.data();
+	size_t* const results = ranks.data();
+	if (count < 4096u)
+	{
+		LowerBoundBatch(elements, results, count);
+		return;
+	}
+
+	Parallel::ForEachRange(count, 4096u, [this, elements, results](size_t, size_t rangeBegin, size_t rangeEnd)
+	{
+		LowerBoundBatch(elements + rangeBegin, results + rangeBegin, rangeEnd - rangeBegin);
+	});
+}
+
+template <typename T, typename Compare>
+bool EytzingerIndex<T, Compare>::contains(const T& key) const
+{
+	size_t node = 1u;
+	while (node <= m_count)
+	{
+		node = Step(node, key);
+	}
+	node = Finish(node);
+	return node != 0u && !m_compare(key, m_tree[node]);
+}
+
+template <typename T, typename Compare>
+size_t EytzingerIndex<T, Compare>::size() const
+{
+	return m_count;
+}
+
+template <typename T, typename Compare>
+bool EytzingerIndex<T, Compare>::empty() const
+{
+	return m_count == 0u;
+}
+
+template <typename T, typename Compare>
+size_t EytzingerIndex<T, Compare>::FloorLog2(size_t value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return index;
+#else
+	return 63u - static_cast<size_t>(__builtin_clzll(value));
+#endif
+}
+
+/**
+ * One branchless level of the search: go right if the node is smaller than key. The prefetch pulls in the cache line
+ * at node * LINE_ELEMENTS, which holds all descendants of node log2(LINE_ELEMENTS) levels down, so that whole subtree
+ * level is in cache when the search gets there (prefetches never fault, even past the end of the tree)
+ */
+template <typename T, typename Compare>
+size_t EytzingerIndex<T, Compare>::Step(size_t node, const T& key) const
+{
+	CompilerHints::Prefetch(m_tree.data() + node * LINE_ELEMENTS);
+	return node * 2u + static_cast<size_t>(m_compare(m_tree[node], key));
+}
+
+/**
+ * The search always ends below a leaf. The lower bound is the last node where it went left: strip the trailing right
+ * turns (1 bits) and that left turn. 0 means the search went right everywhere, there is no lower bound
+ */
+template <typename T, typename Compare>
+size_t EytzingerIndex<T, Compare>::Finish(size_t node) const
+{
+	return node >> (Simd::LowestSetBit(~static_cast<uint64_t>(node)) + 1u);
+}
+
+/**
+ * The number of nodes in the subtree of node. All levels above m_height are complete, only the last one is cut off
+ */
+template <typename T, typename Compare>
+size_t EytzingerIndex<T, Compare>::SubtreeSize(size_t node) const
+{
+	if (node > m_count)
+	{
+		return 0u;
+	}
+	const size_t levelsBelow = m_height - FloorLog2(node);
+	const size_t lastLevelWidth = static_cast<size_t>(1u) << levelsBelow;
+	const size_t lastLevelFirst = node << levelsBelow;
+	const size_t lastLevelCount = m_count >= lastLevelFirst ? (m_count - lastLevelFirst + 1u < lastLevelWidth ? m_count - lastLevelFirst + 1u : lastLevelWidth) : 0u;
+	return lastLevelWidth - 1u + lastLevelCount;
+}
+
+/**
+ * The in-order position of node: its left subtree plus, for every ancestor it lies right of, that ancestor and its
+ * left subtree. Node 0 (no lower bound) maps to size()
+ */
+template <typename T, typename Compare>
+size_t EytzingerIndex<T, Compare>::RankOf(size_t node) const
+{
+	if (node == 0u)
+	{
+		return m_count;
+	}
+	size_t rank = SubtreeSize(node * 2u);
+	for (; node > 1u; node /= 2u)
+	{
+		if ((node & 1u) != 0u)
+		{
+			rank += SubtreeSize(node - 1u) + 1u;
+		}
+	}
+	return rank;
+}
+
+/**
+ * In-order walk of the subtree of node that hands out sorted[next], sorted[next + 1], ... The recursion is only as deep
+ * as the tree is high
+ */
+template <typename T, typename Compare>
+void EytzingerIndex<T, Compare>::Fill(size_t node, const T* sorted, size_t& next)
+{
+	if (node > m_count)
+	{
+		return;
+	}
+	Fill(node * 2u, sorted, next);
+	m_tree[node] = sorted[next++];
+	Fill(node * 2u + 1u, sorted, next);
+}
+
+/**
+ * The first m_height levels are complete, so every lane takes exactly m_height steps without a bounds check, only
+ * the last, partial level needs one
+ */
+template <typename T, typename Compare>
+void EytzingerIndex<T, Compare>::LowerBoundBatch(const T* keys, size_t* ranks, size_t count) const
+{
+	for (size_t first = 0u; first < count; first += BATCH_LANES)
+	{
+		const size_t laneCount = count - first < BATCH_LANES ? count - first : BATCH_LANES;
+		size_t nodes[BATCH_LANES];
+		for (size_t lane = 0u; lane < laneCount; ++lane)
+		{
+			nodes[lane] = 1u;
+		}
+		if (m_count != 0u)
+		{
+			for (size_t level = 0u; level < m_height; ++level)
+			{
+				for (size_t lane = 0u; lane < laneCount; ++lane)
+				{
+					nodes[lane] = Step(nodes[lane], keys[first + lane]);
+				}
+			}
+			for (size_t lane = 0u; lane < laneCount; ++lane)
+			{
+				nodes[lane] = nodes[lane] <= m_count ? Step(nodes[lane], keys[first + lane]) : nodes[lane];
+			}
+		}
+		for (size_t lane = 0u; lane < laneCount; ++lane)
+		{
+			ranks[first + lane] = RankOf(Finish(nodes[lane]));
+		}
+	}
+}
+
+/**
+ * FlatHashMap is an open addressing hash map. Every table is one control byte array plus one slot array, both in
+ * their own Vector reservation. The control bytes of a group of 16 slots are compared with one SSE2 instruction, so
+ * a lookup mostly touches one control cache line and one slot. Control byte 0 marks an empty slot, a fresh table is
+ * committed with resize_zeroed and needs no initialisation pass.
+ * Growing does not rehash in one go: the map switches to a second table and every following insert migrates a few
+ * groups of the old one, so no single insert pays for the whole rehash. Lookups check both tables while that runs.
+ * Pointers to values stay valid until the next insert
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class FlatHashMap
+{
+public:
+	static const size_t GROUP_SIZE = 16u;
+	// Groups of the old table every insert migrates while the map grows
+	static const size_t MIGRATION_GROUPS = 2u;
+
+	explicit FlatHashMap(const Hash& hash = Hash(), const KeyEqual& keyEqual = KeyEqual());
+	~FlatHashMap(void);
+
+	bool insert(const K& key, const V& value);
+	bool erase(const K& key);
+	void clear(void);
+
+	V& operator[](const K& key);
+	V* find(const K& key);
+	const V* find(const K& key) const;
+	bool contains(const K& key) const;
+
+	size_t size(void) const;
+	bool empty(void) const;
+	bool is_migrating(void) const;
+
+private:
+	FlatHashMap(const FlatHashMap& other) = delete;
+	FlatHashMap& operator=(const FlatHashMap& other) = delete;
+
+	struct Entry
+	{
+		K key;
+		V value;
+	};
+	typedef typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type Slot;
+
+	struct Table
+	{
+		Vector<uint8_t> controls;
+		Vector<Slot> slots;
+		// Full slots plus tombstones, both lengthen probe sequences
+		size_t usedCount;
+		size_t fullCount;
+	};
+
+	static const uint8_t EMPTY = 0u;
+	static const uint8_t DELETED = 1u;
+	static const uint8_t FULL = 0x80u;
+	static const size_t NOT_FOUND = ~static_cast<size_t>(0u);
+
+	static uint64_t MixHash(size_t hash);
+	static uint32_t MatchBytes(const uint8_t* group, uint8_t value);
+	static Entry& EntryAt(Table& table, size_t index);
+	static const Entry& EntryAt(const Table& table, size_t index);
+
+	size_t FindIndex(const Table& table, const K& key, uint64_t hash) const;
+	size_t FindFreeIndex(const Table& table, uint64_t hash) const;
+	template <typename Key, typename Value>
+	Entry& Place(Table& table, size_t index, uint64_t hash, Key&& key, Value&& value);
+	void Remove(Table& table, size_t index);
+	Entry& Emplace(const K& key, const V& value);
+	void Grow(void);
+	void Migrate(size_t groupCount);
+	void DestroyAll(Table& table);
+	void Reset(Table& table);
+
+	Table m_tables[2];
+	size_t m_current;
+	// The old table is migrated group by group, m_migrated groups are done. Equal to its group count if nothing runs
+	size_t m_migrated;
+	Hash m_hash;
+	KeyEqual m_keyEqual;
+};
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+FlatHashMap<K, V, Hash, KeyEqual>::FlatHashMap(const Hash& hash, const KeyEqual& keyEqual)
+	: m_current(0u)
+	, m_migrated(0u)
+	, m_hash(hash)
+	, m_keyEqual(keyEqual)
+{
+	for (size_t i = 0u; i < 2u; ++i)
+	{
+		m_tables[i].usedCount = 0u;
+		m_tables[i].fullCount = 0u;
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+FlatHashMap<K, V, Hash, KeyEqual>::~FlatHashMap()
+{
+	DestroyAll(m_tables[0]);
+	DestroyAll(m_tables[1]);
+}
+
+/**
+ * Returns false (and keeps the stored value) if the key was already in the map
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool FlatHashMap<K, V, Hash, KeyEqual>::insert(const K& key, const V& value)
+{
+	if (find(key) != nullptr)
+	{
+		return false;
+	}
+	Emplace(key, value);
+	return true;
+}
+
+/**
+ * Returns false if the key was not in the map. Erased slots turn into tombstones, they are dropped on the next growth
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool FlatHashMap<K, V, Hash, KeyEqual>::erase(const K& key)
+{
+	const uint64_t hash = MixHash(m_hash(key));
+	for (size_t i = 0u; i < 2u; ++i)
+	{
+		Table& table = m_tables[(m_current + i) & 1u];
+		const size_t index = FindIndex(table, key, hash);
+		if (index != NOT_FOUND)
+		{
+			Remove(table, index);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Destroys all entries, the committed memory of the tables is kept for the next inserts
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void FlatHashMap<K, V, Hash, KeyEqual>::clear()
+{
+	DestroyAll(m_tables[0]);
+	DestroyAll(m_tables[1]);
+	Reset(m_tables[0]);
+	Reset(m_tables[1]);
+	m_migrated = 0u;
+}
+
+/**
+ * Returns the value of key, a default constructed value is inserted if the key is missing
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+V& FlatHashMap<K, V, Hash, KeyEqual>::operator[](const K& key)
+{
+	V* value = find(key);
+	return value != nullptr ? *value : Emplace(key, V()).value;
+}
+
+/**
+ * Returns the value of key or nullptr if the key is missing
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+V* FlatHashMap<K, V, Hash, KeyEqual>::find(const K& key)
+{
+	return const_cast<V*>(static_cast<const FlatHashMap*>(this)->find(key));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+const V* FlatHashMap<K, V, Hash, KeyEqual>::find(const K& key) const
+{
+	const uint64_t hash = MixHash(m_hash(key));
+	for (size_t i = 0u; i < 2u; ++i)
+	{
+		const Table& table = m_tables[(m_current + i) & 1u];
+		const size_t index = FindIndex(table, key, hash);
+		if (index != NOT_FOUND)
+		{
+			return &EntryAt(table, index).value;
+		}
+	}
+	return nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool FlatHashMap<K, V, Hash, KeyEqual>::contains(const K& key) const
+{
+	return find(key) != nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t FlatHashMap<K, V, Hash, KeyEqual>::size() const
+{
+	return m_tables[0].fullCount + m_tables[1].fullCount;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool FlatHashMap<K, V, Hash, KeyEqual>::empty() const
+{
+	return size() == 0u;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool FlatHashMap<K, V, Hash, KeyEqual>::is_migrating() const
+{
+	return m_tables[(m_current + 1u) & 1u].controls.size() != 0u;
+}
+
+/**
+ * Hashes like std::hash of integers are often the identity, the finalizer spreads every input bit over the whole
+ * word. The low 7 bits end up in the control byte, the rest picks the first group
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint64_t FlatHashMap<K, V, Hash, KeyEqual>::MixHash(size_t hash)
+{
+	uint64_t mixed = static_cast<uint64_t>(hash);
+	mixed ^= mixed >> 33;
+	mixed *= 0xFF51AFD7ED558CCDull;
+	mixed ^= mixed >> 33;
+	mixed *= 0xC4CEB9FE1A85EC53ull;
+	mixed ^= mixed >> 33;
+	return mixed;
+}
+
+/**
+ * Bit i is set if group[i] == value
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint32_t FlatHashMap<K, V, Hash, KeyEqual>::MatchBytes(const uint8_t* group, uint8_t value)
+{
+	const __m128i controls = _mm_load_si128(reinterpret_cast<const __m128i*>(group));
+	return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8(static_cast<char>(value)))));
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+typename FlatHashMap<K, V, Hash, KeyEqual>::Entry& FlatHashMap<K, V, Hash, KeyEqual>::EntryAt(Table& table, size_t index)
+{
+	return *reinterpret_cast<Entry*>(table.slots.data() + index);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+const typename FlatHashMap<K, V, Hash, KeyEqual>::Entry& FlatHashMap<K, V, Hash, KeyEqual>::EntryAt(const Table& table, size_t index)
+{
+	return *reinterpret_cast<const Entry*>(table.slots.data() + index);
+}
+
+/**
+ * Probes the groups in triangular order (1, 2, 3, ... groups further), which visits every group once for a power of
+ * two group count. A group with an empty slot ends the search, the key would have been placed there
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t FlatHashMap<K, V, Hash, KeyEqual>::FindIndex(const Table& table, const K& key, uint64_t hash) const
+{
+	const size_t groupCount = table.controls.size() / GROUP_SIZE;
+	if (table.fullCount == 0u)
+	{
+		return NOT_FOUND;
+	}
+
+	const uint8_t tag = static_cast<uint8_t>(FULL | (hash & 0x7Fu));
+	size_t group = static_cast<size_t>(hash >> 7) & (groupCount - 1u);
+	for (size_t probe = 1u; probe <= groupCount; ++probe)
+	{
+		const uint8_t* const controls = table.controls.data() + group * GROUP_SIZE;
+		for (uint32_t matches = MatchBytes(controls, tag); matches != 0u; matches &= matches - 1u)
+		{
+			const size_t index = group * GROUP_SIZE + Simd::LowestSetBit(matches);
+			if (m_keyEqual(EntryAt(table, index).key, key))
+			{
+				return index;
+			}
+		}
+		if (MatchBytes(controls, EMPTY) != 0u)
+		{
+			return NOT_FOUND;
+		}
+		group = (group + probe) & (groupCount - 1u);
+	}
+	return NOT_FOUND;
+}
+
+/**
+ * The first empty slot or tombstone on the probe sequence of hash. The load limit guarantees there is one
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t FlatHashMap<K, V, Hash, KeyEqual>::FindFreeIndex(const Table& table, uint64_t hash) const
+{
+	const size_t groupCount = table.controls.size() / GROUP_SIZE;
+	size_t group = static_cast<size_t>(hash >> 7) & (groupCount - 1u);
+	for (size_t probe = 1u; ; ++probe)
+	{
+		const uint8_t* const controls = table.controls.data() + group * GROUP_SIZE;
+		// Full slots have the top bit set, empty slots and tombstones not
+		const uint32_t free = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(controls)))) & 0xFFFFu;
+		if (free != 0u)
+		{
+			return group * GROUP_SIZE + Simd::LowestSetBit(free);
+		}
+		group = (group + probe) & (groupCount - 1u);
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename Key, typename Value>
+typename FlatHashMap<K, V, Hash, KeyEqual>::Entry& FlatHashMap<K, V, Hash, KeyEqual>::Place(Table& table, size_t index, uint64_t hash, Key&& key, Value&& value)
+{
+	Entry* const entry = reinterpret_cast<Entry*>(table.slots.data() + index);
+	new (&entry->key) K(std::forward<Key>(key));
+	new (&entry->value) V(std::forward<Value>(value));
+	table.usedCount += static_cast<size_t>(table.controls[index] == EMPTY);
+	++table.fullCount;
+	table.controls[index] = static_cast<uint8_t>(FULL | (hash & 0x7Fu));
+	return *entry;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void FlatHashMap<K, V, Hash, KeyEqual>::Remove(Table& table, size_t index)
+{
+	Entry& entry = EntryAt(table, index);
+	entry.key.~K();
+	entry.value.~V();
+	table.controls[index] = DELETED;
+	--table.fullCount;
+}
+
+/**
+ * Inserts a key that is not in the map yet. New keys always go into the current table, which stays below 7/8 load
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+typename FlatHashMap<K, V, Hash, KeyEqual>::Entry& FlatHashMap<K, V, Hash, KeyEqual>::Emplace(const K& key, const V& value)
+{
+	if (is_migrating())
+	{
+		Migrate(MIGRATION_GROUPS);
+	}
+	Table* table = &m_tables[m_current];
+	if ((table->usedCount + 1u) * 8u > table->controls.size() * 7u)
+	{
+		Grow();
+		table = &m_tables[m_current];
+	}
+
+	const uint64_t hash = MixHash(m_hash(key));
+	return Place(*table, FindFreeIndex(*table, hash), hash, key, value);
+}
+
+/**
+ * Commits the next table in the other reservation: twice as big, or just as big if mostly tombstones filled the
+ * current one. A migration that is still running has to finish first, the map only has two tables.
+ * With MIGRATION_GROUPS >= 2 the old table is empty before the new one reaches its load limit, so that only happens
+ * after heavy erasing
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void FlatHashMap<K, V, Hash, KeyEqual>::Grow()
+{
+	if (is_migrating())
+	{
+		Migrate(~static_cast<size_t>(0u));
+	}
+
+	const Table& current = m_tables[m_current];
+	const size_t capacity = current.controls.size();
+	const size_t newCapacity = capacity == 0u ? GROUP_SIZE : ((current.fullCount + 1u) * 2u > capacity ? capacity * 2u : capacity);
+
+	const size_t next = (m_current + 1u) & 1u;
+	Table& table = m_tables[next];
+	table.controls.resize_zeroed(newCapacity);
+	table.slots.resize_uninitialized(newCapacity);
+	m_current = next;
+	m_migrated = 0u;
+	if (current.fullCount == 0u)
+	{
+		// Nothing to migrate, the old table only held tombstones
+		Reset(m_tables[(next + 1u) & 1u]);
+	}
+}
+
+/**
+ * Moves the full slots of the next groupCount groups of the old table into the current one. The moved slots become
+ * tombstones, so lookups of keys further back in the old table still probe past them. Once all groups are done the
+ * old table is released
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void FlatHashMap<K, V, Hash, KeyEqual>::Migrate(size_t groupCount)
+{
+	Table& source = m_tables[(m_current + 1u) & 1u];
+	Table& target = m_tables[m_current];
+	const size_t sourceGroupCount = source.controls.size() / GROUP_SIZE;
+	const size_t groupEnd = sourceGroupCount - m_migrated > groupCount ? m_migrated + groupCount : sourceGroupCount;
+	for (; m_migrated < groupEnd; ++m_migrated)
+	{
+		const uint8_t* const controls = source.controls.data() + m_migrated * GROUP_SIZE;
+		for (uint32_t full = static_cast<uint32_t>(_mm_movemask_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(controls)))); full != 0u; full &= full - 1u)
+		{
+			const size_t index = m_migrated * GROUP_SIZE + Simd::LowestSetBit(full);
+			Entry& entry = EntryAt(source, index);
+			const uint64_t hash = MixHash(m_hash(entry.key));
+			Place(target, FindFreeIndex(target, hash), hash, std::move(entry.key), std::move(entry.value));
+			Remove(source, index);
+		}
+	}
+
+	if (m_migrated == sourceGroupCount || source.fullCount == 0u)
+	{
+		Reset(source);
+	}
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void FlatHashMap<K, V, Hash, KeyEqual>::DestroyAll(Table& table)
+{
+	if (std::is_trivially_destructible<Entry>::value)
+	{
+		return;
+	}
+	for (size_t index = 0u; index < table.controls.size(); ++index)
+	{
+		if ((table.controls[index] & FULL) != 0u)
+		{
+			Remove(table, index);
+		}
+	}
+}
+
+/**
+ * Drops the slots of an empty table. The memory stays committed, resize_zeroed clears it on reuse
+ */
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void FlatHashMap<K, V, Hash, KeyEqual>::Reset(Table& table)
+{
+	table.controls.resize(0u);
+	table.slots.resize(0u);
+	table.usedCount = 0u;
+	table.fullCount = 0u;
+}
+
+/**
+ * PriorityQueue is a D-ary max heap (top() is the largest element under Compare, like std::priority_queue) on a
+ * Vector<T>. The D children of a node are stored next to each other, so picking the best child reads one group
+ * instead of one cache line per level, and the tree is only log_D(n) levels deep.
+ * The heap starts D - 1 slots into the vector. The first child group then starts at index D and all child groups
+ * start at multiples of D * sizeof(T) bytes. If D * sizeof(T) divides 64 (e.g. D = 4 or 8 with 8 byte elements) a group
+ * never straddles a cache line, the vector memory is page aligned. Other sizes still work, their groups just may span
+ * two lines. The padding slots are default constructed, so T has to be default constructible
+ */
+template <typename T, typename Compare = std::less<T>, size_t D = 4u>
+class PriorityQueue
+{
+	static_assert(D >= 2u, "PriorityQueue needs at least two children per node");
+
+public:
+	static const size_t PADDING = D - 1u;
+
+	explicit PriorityQueue(const Compare& compare = Compare());
+
+	void push(const T& object);
+	void pop(void);
+	const T& top(void) const;
+
+	void heapify(const Vector<T>& elements);
+	void push_many(const Vector<T>& elements);
+	void pop_many(size_t count, Vector<T>& target);
+	void clear(void);
+
+	size_t size(void) const;
+	bool empty(void) const;
+
+private:
+	PriorityQueue(const PriorityQueue& other) = delete;
+	PriorityQueue& operator=(const PriorityQueue& other) = delete;
+
+	T* Nodes(void);
+	void SiftUp(size_t index);
+	void SiftDown(T* nodes, size_t index, size_t count) const;
+	void BuildHeap(void);
+
+	Vector<T> m_heap;
+	Compare m_compare;
+};
+
+template <typename T, typename Compare, size_t D>
+PriorityQueue<T, Compare, D>::PriorityQueue(const Compare& compare)
+	: m_compare(compare)
+{
+	m_heap.resize(PADDING);
+}
+
+template <typename T, typename Compare, size_t D>
+void PriorityQueue<T, Compare, D>::push(const T& object)
+{
+	m_heap.push_back(object);
+	SiftUp(size() - 1u);
+}
+
+template <typename T, typename Compare, size_t D>
+void PriorityQueue<T, Compare, D>::pop()
+{
+	{ const bool isEmpty = empty(); assert("Pop on an empty PriorityQueue" && !isEmpty); }
+	T* const nodes = Nodes();
+	const size_t count = size() - 1u;
+	if (count != 0u)
+	{
+		nodes[0] = std::move(nodes[count]);
+	}
+	m_heap.pop_back();
+	SiftDown(Nodes(), 0u, count);
+}
+
+template <typename T, typename Compare, size_t D>
+const T& PriorityQueue<T, Compare, D>::top() const
+{
+	{ const bool isEmpty = empty(); assert("Top on an empty PriorityQueue" && !isEmpty); }
+	return m_heap[PADDING];
+}
+
+/**
+ * Replaces the content with elements and builds the heap bottom up in O(n) (see BuildHeap)
+ */
+template <typename T, typename Compare, size_t D>
+void PriorityQueue<T, Compare, D>::heapify(const Vector<T>& elements)
+{
+	m_heap.resize(PADDING);
+	m_heap.insert(PADDING, elements.begin(), elements.end());
+	BuildHeap();
+}
+
+/**
+ * Adds all elements. A batch at least as big as the heap is appended and the whole heap is rebuilt, which is cheaper
+ * than sifting every element up on its own
+ */
+template <typename T, typename Compare, size_t D>
+void PriorityQueue<T, Compare, D>::push_many(const Vector<T>& elements)
+{
+	if (elements.size() < size())
+	{
+		for (size_t i = 0u; i < elements.size(); ++i)
+		{
+			push(elements[i]);
+		}
+		return;
+	}
+
+	m_heap.insert(m_heap.size(), elements.begin(), elements.end());
+	BuildHeap();
+}
+
+/**
+ * Pops the count (at most size()) top elements and appends them to target in priority order. target grows once for
+ * the whole batch. Draining the whole queue skips the sifts: the heap is appended as it is, sorted once and cleared
+ */
+template <typename T, typename Compare, size_t D>
+void PriorityQueue<T, Compare, D>::pop_many(size_t count, Vector<T>& target)
+{
+	count = count < size() ? count : size();
+	const size_t targetBegin = target.size();
+	target.reserve(targetBegin + count);
+	if (count == size())
+	{
+		target.insert(targetBegin, m_heap.begin() + PADDING, m_heap.end());
+		const Compare& compare = m_compare;
+		std::sort(target.begin() + targetBegin, target.end(), [&compare](const T& left, const T& right) { return compare(right, left); });
+		clear();
+		return;
+	}
+
+	for (size_t i = 0u; i < count; ++i)
+	{
+		target.push_back(top());
+		pop();
+	}
+}
+
+template <typename T, typename Compare, size_t D>
+void PriorityQueue<T, Compare, D>::clear()
+{
+	m_heap.resize(PADDING);
+}
+
+template <typename T, typename Compare, size_t D>
+size_t PriorityQueue<T, Compare, D>::size() const
+{
+	return m_heap.size() - PADDING;
+}
+
+template <typename T, typename Compare, size_t D>
+bool PriorityQueue<T, Compare, D>::empty() const
+{
+	return m_heap.size() == PADDING;
+}
+
+template <typename T, typename Compare, size_t D>
+T* PriorityQueue<T, Compare, D>::Nodes()
+{
+	return m_heap.data() + PADDING;
+}
+
+/**
+ * Moves the element at index up as a hole: parents slide down and the element is written once at its final place
+ */
+template <typename T, typename Compare, size_t D>
+void PriorityQueue<T, Compare, D>::SiftUp(size_t index)
+{
+	T* const nodes = Nodes();
+	T object = std::move(nodes[index]);
+	while (index > 0u)
+	{
+		const size_t parent = (index - 1u) / D;
+		if (!m_compare(nodes[parent], object))
+		{
+			break;
+		}
+		nodes[index] = std::move(nodes[parent]);
+		index = parent;
+	}
+	nodes[index] = std::move(object);
+}
+
+/**
+ * Moves the element at index down as a hole. While the best child of a group is picked, the child group of the
+ * first child is prefetched, that is where the next level most likely continues for random input
+ */
+template <typename T, typename Compare, size_t D>
+void PriorityQueue<T, Compare, D>::SiftDown(T* nodes, size_t index, size_t count) const
+{
+	if (index >= count)
+	{
+		return;
+	}
+	T object = std::move(nodes[index]);
+	for (;;)
+	{
+		const size_t firstChild = index * D + 1u;
+		if (firstChild >= count)
+		{
+			break;
+		}
+		CompilerHints::Prefetch(nodes + firstChild * D + 1u);
+		const size_t childEnd = firstChild + D < count ? firstChild + D : count;
+		size_t best = firstChild;
+		for (size_t child = firstChild + 1u; child < childEnd; ++child)
+		{
+			best = m_compare(nodes[best], nodes[child]) ? child : best;
+		}
+		if (!m_compare(object, nodes[best]))
+		{
+			break;
+		}
+		nodes[index] = std::move(nodes[best]);
+		index = best;
+	}
+	nodes[index] = std::move(object);
+}
+
+/**
+ * Floyd's bottom up construction, one tree level at a time from the last parent upwards. The subtrees of one level
+ * are disjoint, so big levels sift down in parallel on the ThreadPool (Compare is called concurrently then)
+ */
+template <typename T, typename Compare, size_t D>
+void PriorityQueue<T, Compare, D>::BuildHeap()
+{
+	const size_t count = size();
+	if (count < 2u)
+	{
+		return;
+	}
+
+	T* const nodes = Nodes();
+	const size_t lastParent = (count - 2u) / D;
+	const bool isParallel = count * sizeof(T) >= Simd::PARALLEL_SCAN_BYTES;
+
+	// levelBegins[level] is the first node of that level, the tree of a Vector has less than 64 levels
+	size_t levelBegins[64];
+	size_t levelCount = 0u;
+	for (size_t levelBegin = 0u; levelBegin <= lastParent; levelBegin = levelBegin * D + 1u)
+	{
+		levelBegins[levelCount++] = levelBegin;
+	}
+
+	while (levelCount > 0u)
+	{
+		const size_t levelBegin = levelBegins[--levelCount];
+		const size_t levelEnd = levelBegin * D + 1u <= lastParent ? levelBegin * D + 1u : lastParent + 1u;
+		if (!isParallel || levelEnd - levelBegin < 1024u)
+		{
+			for (size_t node = levelEnd; node > levelBegin; --node)
+			{
+				SiftDown(nodes, node - 1u, count);
+			}
+			continue;
+		}
+
+		Parallel::ForEachRange(levelEnd - levelBegin, 1024u, [this, nodes, levelBegin, count](size_t, size_t rangeBegin, size_t rangeEnd)
+		{
+			for (size_t node = levelBegin + rangeBegin; node < levelBegin + rangeEnd; ++node)
+			{
+				SiftDown(nodes, node, count);
+			}
+		});
+	}
+}
+
+template <typename... Fields> class SoAVector;
+
+/**
+ * StructureOfArrays namespace holds the column view of SoAVector and the helpers of the AoS <-> SoA conversions
+ */
+namespace StructureOfArrays
+{
+	/**
+	 * ColumnSpan is a view of one column: a pointer and a row count. It stays valid until the next change of the
+	 * SoAVector's size, the columns themselves never move
+	 */
+	template <typename T>
+	class ColumnSpan
+	{
+	public:
+		typedef T* iterator;
+
+		ColumnSpan(T* elements, size_t count);
+
+		T* data(void) const;
+		size_t size(void) const;
+		bool empty(void) const;
+		T& operator[](size_t index) const;
+		iterator begin(void) const;
+		iterator end(void) const;
+
+	private:
+		T* m_elements;
+		size_t m_count;
+	};
+
+	template <typename T>
+	ColumnSpan<T>::ColumnSpan(T* elements, size_t count)
+		: m_elements(elements)
+		, m_count(count)
+	{
+	}
+
+	template <typename T>
+	T* ColumnSpan<T>::data() const
+	{
+		return m_elements;
+	}
+
+	template <typename T>
+	size_t ColumnSpan<T>::size() const
+	{
+		return m_count;
+	}
+
+	template <typename T>
+	bool ColumnSpan<T>::empty() const
+	{
+		return m_count == 0u;
+	}
+
+	template <typename T>
+	T& ColumnSpan<T>::operator[](size_t index) const
+	{
+		{ const bool isInRange = index < m_count; assert("ColumnSpan index out of range" && isInRange); }
+		return m_elements[index];
+	}
+
+	template <typename T>
+	typename ColumnSpan<T>::iterator ColumnSpan<T>::begin() const
+	{
+		return m_elements;
+	}
+
+	template <typename T>
+	typename ColumnSpan<T>::iterator ColumnSpan<T>::end() const
+	{
+		return m_elements + m_count;
+	}
+
+	// Rows per task of the parallel conversions
+	static const size_t CONVERSION_BLOCK_ROWS = 16384u;
+
+	/**
+	 * Copies one field of records [rangeBegin, rangeEnd) into its column. Every loop streams one column only
+	 */
+	template <typename Record, typename Field>
+	void CopyToColumn(const Record* records, size_t rangeBegin, size_t rangeEnd, Field* column, Field Record::* member)
+	{
+		for (size_t row = rangeBegin; row < rangeEnd; ++row)
+		{
+			column[row] = records[row].*member;
+		}
+	}
+
+	template <typename Record, typename Field>
+	void CopyFromColumn(Record* records, size_t rangeBegin, size_t rangeEnd, const Field* column, Field Record::* member)
+	{
+		for (size_t row = rangeBegin; row < rangeEnd; ++row)
+		{
+			records[row].*member = column[row];
+		}
+	}
+
+	template <typename Record, typename... Fields, size_t... I>
+	void ToColumns(const Record* records, size_t rangeBegin, size_t rangeEnd, const std::tuple<Fields*...>& columns, const std::tuple<Fields Record::*...>& members, std::index_sequence<I...>)
+	{
+		(void)std::initializer_list<int>{ (CopyToColumn(records, rangeBegin, rangeEnd, std::get<I>(columns), std::get<I>(members)), 0)... };
+	}
+
+	template <typename Record, typename... Fields, size_t... I>
+	void FromColumns(Record* records, size_t rangeBegin, size_t rangeEnd, const std::tuple<const Fields*...>& columns, const std::tuple<Fields Record::*...>& members, std::index_sequence<I...>)
+	{
+		(void)std::initializer_list<int>{ (CopyFromColumn(records, rangeBegin, rangeEnd, std::get<I>(columns), std::get<I>(members)), 0)... };
+	}
+
+	template <typename... Fields, size_t... I>
+	std::tuple<Fields*...> ColumnData(SoAVector<Fields...>& soa, std::index_sequence<I...>)
+	{
+		return std::tuple<Fields*...>(soa.template column<I>().data()...);
+	}
+
+	template <typename... Fields, size_t... I>
+	std::tuple<const Fields*...> ColumnData(const SoAVector<Fields...>& soa, std::index_sequence<I...>)
+	{
+		return std::tuple<const Fields*...>(soa.template column<I>().data()...);
+	}
+
+	/**
+	 * Runs work(rangeBegin, rangeEnd) over all rows, on the ThreadPool once the records are a few MB big
+	 */
+	template <typename Work>
+	void ForEachRowRange(size_t count, size_t recordSize, Work work)
+	{
+		if (count * recordSize < Simd::PARALLEL_SCAN_BYTES)
+		{
+			work(0u, count);
+			return;
+		}
+		Parallel::ForEachRange(count, CONVERSION_BLOCK_ROWS, [&work](size_t, size_t rangeBegin, size_t rangeEnd)
+		{
+			work(rangeBegin, rangeEnd);
+		});
+	}
+}
+
+/**
+ * SoAVector stores records column by column: one Vector (and so one reservation) per field. A scan over one field
+ * only pulls the bytes of that field through the cache, and every column is a plain array for the SIMD kernels.
+ * All columns grow in lockstep: the SoAVector applies the Vector growth policy (8 rows, then doubling) to its row
+ * capacity and reserves that in every column, so they always hold the same number of rows and reallocate together.
+ * Rows are accessed through proxy references, tuples of references to the fields
+ */
+template <typename... Fields>
+class SoAVector
+{
+	static_assert(sizeof...(Fields) > 0u, "SoAVector needs at least one field");
+
+public:
+	typedef std::tuple<Fields&...> reference;
+	typedef std::tuple<const Fields&...> const_reference;
+	template <size_t I>
+	using FieldType = typename std::tuple_element<I, std::tuple<Fields...>>::type;
+
+	SoAVector(void);
+
+	void push_back(const Fields&... values);
+	void pop_back(void);
+	void resize(size_t newSize);
+	void reserve(size_t newCapacity);
+	void clear(void);
+
+	reference operator[](size_t index);
+	const_reference operator[](size_t index) const;
+
+	template <size_t I>
+	StructureOfArrays::ColumnSpan<FieldType<I>> column(void);
+	template <size_t I>
+	StructureOfArrays::ColumnSpan<const FieldType<I>> column(void) const;
+
+	size_t size(void) const;
+	size_t capacity(void) const;
+	bool empty(void) const;
+
+private:
+	SoAVector(const SoAVector& other) = delete;
+	SoAVector& operator=(const SoAVector& other) = delete;
+
+	typedef std::index_sequence_for<Fields...> FieldIndices;
+
+	template <size_t... I>
+	void PushBack(std::index_sequence<I...>, const Fields&... values);
+	template <typename Function, size_t... I>
+	void ForEachColumn(Function function, std::index_sequence<I...>);
+	template <size_t... I>
+	reference Row(size_t index, std::index_sequence<I...>);
+	template <size_t... I>
+	const_reference Row(size_t index, std::index_sequence<I...>) const;
+	void GrowToFit(size_t requiredCapacity);
+
+	std::tuple<Vector<Fields>...> m_columns;
+	size_t m_size;
+	size_t m_capacity;
+};
+
+template <typename... Fields>
+SoAVector<Fields...>::SoAVector()
+	: m_size(0u)
+	, m_capacity(0u)
+{
+}
+
+template <typename... Fields>
+void SoAVector<Fields...>::push_back(const Fields&... values)
+{
+	GrowToFit(m_size + 1u);
+	PushBack(FieldIndices(), values...);
+	++m_size;
+}
+
+template <typename... Fields>
+void SoAVector<Fields...>::pop_back()
+{
+	{ const bool isEmpty = empty(); assert("Pop back on an empty SoAVector" && !isEmpty); }
+	ForEachColumn([](auto& column) { column.pop_back(); }, FieldIndices());
+	--m_size;
+}
+
+/**
+ * New rows are default constructed in every column
+ */
+template <typename... Fields>
+void SoAVector<Fields...>::resize(size_t newSize)
+{
+	GrowToFit(newSize);
+	ForEachColumn([newSize](auto& column) { column.resize(newSize); }, FieldIndices());
+	m_size = newSize;
+}
+
+template <typename... Fields>
+void SoAVector<Fields...>::reserve(size_t newCapacity)
+{
+	if (newCapacity <= m_capacity)
+	{
+		return;
+	}
+	ForEachColumn([newCapacity](auto& column) { column.reserve(newCapacity); }, FieldIndices());
+	m_capacity = newCapacity;
+}
+
+template <typename... Fields>
+void SoAVector<Fields...>::clear()
+{
+	resize(0u);
+}
+
+/**
+ * Returns a proxy row: std::get<I>(row) is a reference into column I. Assigning a tuple of values writes all fields
+ */
+template <typename... Fields>
+typename SoAVector<Fields...>::reference SoAVector<Fields...>::operator[](size_t index)
+{
+	{ const bool isInRange = index < m_size; assert("SoAVector index out of range" && isInRange); }
+	return Row(index, FieldIndices());
+}
+
+template <typename... Fields>
+typename SoAVector<Fields...>::const_reference SoAVector<Fields...>::operator[](size_t index) const
+{
+	{ const bool isInRange = index < m_size; assert("SoAVector index out of range" && isInRange); }
+	return Row(index, FieldIndices());
+}
+
+template <typename... Fields>
+template <size_t I>
+StructureOfArrays::ColumnSpan<typename SoAVector<Fields...>::template FieldType<I>> SoAVector<Fields...>::column()
+{
+	return StructureOfArrays::ColumnSpan<FieldType<I>>(std::get<I>(m_columns).data(), m_size);
+}
+
+template <typename... Fields>
+template <size_t I>
+StructureOfArrays::ColumnSpan<const typename SoAVector<Fields...>::template FieldType<I>> SoAVector<Fields...>::column() const
+{
+	return StructureOfArrays::ColumnSpan<const FieldType<I>>(std::get<I>(m_columns).data(), m_size);
+}
+
+template <typename... Fields>
+size_t SoAVector<Fields...>::size() const
+{
+	return m_size;
+}
+
+/**
+ * The row capacity every column has reserved (a column may have committed a bit more to fill its last page)
+ */
+template <typename... Fields>
+size_t SoAVector<Fields...>::capacity() const
+{
+	return m_capacity;
+}
+
+template <typename... Fields>
+bool SoAVector<Fields...>::empty() const
+{
+	return m_size == 0u;
+}
+
+template <typename... Fields>
+template <size_t... I>
+void SoAVector<Fields...>::PushBack(std::index_sequence<I...>, const Fields&... values)
+{
+	(void)std::initializer_list<int>{ (std::get<I>(m_columns).push_back(values), 0)... };
+}
+
+template <typename... Fields>
+template <typename Function, size_t... I>
+void SoAVector<Fields...>::ForEachColumn(Function function, std::index_sequence<I...>)
+{
+	(void)std::initializer_list<int>{ (function(std::get<I>(m_columns)), 0)... };
+}
+
+template <typename... Fields>
+template <size_t... I>
+typename SoAVector<Fields...>::reference SoAVector<Fields...>::Row(size_t index, std::index_sequence<I...>)
+{
+	return reference(std::get<I>(m_columns)[index]...);
+}
+
+template <typename... Fields>
+template <size_t... I>
+typename SoAVector<Fields...>::const_reference SoAVector<Fields...>::Row(size_t index, std::index_sequence<I...>) const
+{
+	return const_reference(std::get<I>(m_columns)[index]...);
+}
+
+/**
+ * Same growth policy as Vector (see Vector::GetGrowSizeInElements), but in rows and for all columns at once
+ */
+template <typename... Fields>
+void SoAVector<Fields...>::GrowToFit(size_t requiredCapacity)
+{
+	if (requiredCapacity <= m_capacity)
+	{
+		return;
+	}
+	const size_t grownCapacity = m_capacity ? m_capacity * 2u : 8u;
+	reserve(requiredCapacity > grownCapacity ? requiredCapacity : grownCapacity);
+}
+
+/**
+ * to_soa replaces the content of target with the given fields of records, members[i] fills column i:
+ * to_soa(particles, soa, &Particle::x, &Particle::y). Each column is written in its own pass per block of rows,
+ * large inputs are split across the ThreadPool
+ */
+template <typename Record, typename... Fields>
+void to_soa(const Vector<Record>& records, SoAVector<Fields...>& target, Fields Record::*... members)
+{
+	const size_t count = records.size();
+	target.resize(count);
+	const Record* const elements = records.data();
+	const std::tuple<Fields*...> columns = StructureOfArrays::ColumnData(target, std::index_sequence_for<Fields...>());
+	const std::tuple<Fields Record::*...> memberPointers(members...);
+	StructureOfArrays::ForEachRowRange(count, sizeof(Record), [elements, &columns, &memberPointers](size_t rangeBegin, size_t rangeEnd)
+	{
+		StructureOfArrays::ToColumns(elements, rangeBegin, rangeEnd, columns, memberPointers, std::index_sequence_for<Fields...>());
+	});
+}
+
+/**
+ * from_soa is the inverse of to_soa: target gets one default constructed record per row, then column i is written
+ * into members[i]
+ */
+template <typename Record, typename... Fields>
+void from_soa(const SoAVector<Fields...>& source, Vector<Record>& target, Fields Record::*... members)
+{
+	const size_t count = source.size();
+	target.resize(count);
+	Record* const elements = target.data();
+	const std::tuple<const Fields*...> columns = StructureOfArrays::ColumnData(source, std::index_sequence_for<Fields...>());
+	const std::tuple<Fields Record::*...> memberPointers(members...);
+	StructureOfArrays::ForEachRowRange(count, sizeof(Record), [elements, &columns, &memberPointers](size_t rangeBegin, size_t rangeEnd)
+	{
+		StructureOfArrays::FromColumns(elements, rangeBegin, rangeEnd, columns, memberPointers, std::index_sequence_for<Fields...>());
+	});
+}
+
+/// ++++++++++++++++++++++++++++++++++++++++++
+/// ++++++++++++++ TEST PROGRAM ++++++++++++++
+/// ++++++++++++++++++++++++++++++++++++++++++
+
+namespace UnitTests
+{
+	void Construction()
+	{
+		Vector<int> intVec;
+		assert("Initial capacity was not 0" && intVec.capacity() == 0);
+		assert("Initial size was not 0" && intVec.size() == 0);
+	}
+
+	void CopyConstruction()
+	{
+		Vector<size_t> firstVector;
+
+		firstVector.push_back(123u);
+		firstVector.push_back(456u);
+		firstVector.push_back(789u);
+		firstVector.push_back(123456789u);
+
+		Vector<size_t> testVector(firstVector);
+		assert("Vector size mismatch" && firstVector.size() == testVector.size());
+		assert("Vector capacity mismatch" && firstVector.capacity() == testVector.capacity());
+
+		assert(testVector[0] == 123u);
+		assert(testVector[1] == 456u);
+		assert(testVector[2] == 789u);
+		assert(testVector[3] == 123456789u);
+	}
+
+	void CopyLarge()
+	{
+		Vector<size_t> source;
+		source.reserve(4000000);
+		for (size_t i = 0; i < 2000000; ++i)
+		{
+			source.push_back(i * 3u);
+		}
+
+		Vector<size_t> copy(source);
+		assert("Vector size mismatch" && copy.size() == source.size());
+		assert("Copy committed the unused capacity of the source" && copy.capacity() < source.capacity());
+		for (size_t i = 0; i < copy.size(); ++i)
+		{
+			assert("Vector value mismatch" && copy[i] == i * 3u);
+		}
+
+		Vector<size_t> assigned;
+		assigned.push_back(1u);
+		assigned = source;
+		assert("Vector size mismatch" && assigned.size() == source.size());
+		for (size_t i = 0; i < assigned.size(); ++i)
+		{
+			assert("Vector value mismatch" && assigned[i] == i * 3u);
+		}
+	}
+
+	void Assignment()
 	{
 		Vector<size_t> smallVector;
 		smallVector.push_back(123u);
 		smallVector.push_back(456u);
 		smallVector.push_back(789u);
 
-		Vector<size_t> mediumVector;
-		mediumVector.push_back(13u);
-		mediumVector.push_back(57u);
-		mediumVector.push_back(911u);
-		mediumVector.push_back(24u);
-		mediumVector.push_back(68u);
-		mediumVector.push_back(1012u);
+		Vector<size_t> mediumVector;
+		mediumVector.push_back(13u);
+		mediumVector.push_back(57u);
+		mediumVector.push_back(911u);
+		mediumVector.push_back(24u);
+		mediumVector.push_back(68u);
+		mediumVector.push_back(1012u);
+
+		Vector<size_t> largeVector;
+		largeVector.push_back(312u);
+		largeVector.push_back(654u);
+		largeVector.push_back(987u);
+		largeVector.push_back(121110u);
+		largeVector.push_back(151413u);
+		largeVector.push_back(181716u);
+		largeVector.push_back(212019u);
+		largeVector.push_back(242322u);
+		largeVector.push_back(272625u);
+
+		// test assignment of larger vector
+		mediumVector = largeVector;
+		assert("Vector size mismatch" && mediumVector.size() == largeVector.size());
+		assert("Vector capacity mismatch" && mediumVector.capacity() == largeVector.capacity());
+
+		assert(mediumVector[0] == 312u);
+		assert(mediumVector[1] == 654u);
+		assert(mediumVector[2] == 987u);
+		assert(mediumVector[3] == 121110u);
+		assert(mediumVector[4] == 151413u);
+		assert(mediumVector[5] == 181716u);
+		assert(mediumVector[6] == 212019u);
+		assert(mediumVector[7] == 242322u);
+		assert(mediumVector[8] == 272625u);
+
+		// test assignment of smaller vector
+		largeVector = smallVector;
+		assert("Vector size mismatch" && largeVector.size() == smallVector.size());
+		assert("Vector capacity mismatch" && largeVector.capacity() == smallVector.capacity());
+
+		assert(smallVector[0] == 123u);
+		assert(smallVector[1] == 456u);
+		assert(smallVector[2] == 789u);
+	}
+
+	void PushBack()
+	{
+		Vector<size_t> firstVec;
+
+		for (size_t i = 0; i < 5; ++i)
+		{
+			firstVec.push_back(i);
+		}
+
+		assert("Size should equal 5" && firstVec.size() == 5);
+
+		for (size_t i = 0; i < 5; ++i)
+		{
+			assert("Vector value mismatch" && firstVec[i] == i);
+		}
+	}
+
+	void PushBackDepleteResources()
+	{
+		Vector<size_t> v;
+
+		// Vector can hold 134217727 size_ts on 64 bit in 1GB mem
+		for (size_t i = 0; i < 134217728; ++i)
+		{
+			v.push_back(0u);
+		}
+
+		// Pushing another element would exceed the available address space and asserts
+		v.push_back(666u);
+	}
+
+	void Reserve()
+	{
+		Vector<int> vec;
+		// We want to reserve spce for 100 ints (100 * 4 = 400 bytes mem), because we use VirtualMem
+		// we can only allocate in page size chunks and will reserve here at least 4KB (4096 bytes) mem, so the
+		// capacity shall be 1024 after the reserve call
+		vec.reserve(100);
+		assert("Capacity did not match the expected grow behaviour" && vec.capacity() == 1024);
+	}
+
+	void TooBigReserve()
+	{
+		Vector<size_t> v;
+		// 1GB on 64bit could hold 134217728 size_ts
+		v.reserve(134217729); // A reserve request that would exceed the max_capacity asserts
+	}
+
+	void ResizeDefaultCtor(size_t initialSize, size_t resizeSize)
+	{
+		Vector<size_t> vec;
+		for (size_t i = 0; i < initialSize; ++i)
+		{
+			vec.push_back(i);
+		}
+		vec.resize(resizeSize);
+		assert("Vector size did not changed as requested" && vec.size() == resizeSize);
+	}
+
+	void ResizeBigDefaultCtor()
+	{
+		Vector<int> testVector;
+		testVector.resize(2500, 0xDEADBEEF);
+
+		assert(testVector.size() == 2500);
+		const size_t capacity = testVector.capacity();
+
+		testVector.resize(500);
+
+		assert(testVector.size() == 500);
+		assert(testVector.capacity() == capacity);
+	}
+
+	void ResizeWithValue(size_t initialSize, size_t resizeSize)
+	{
+		Vector<size_t> vec;
+		for (size_t i = 0; i < initialSize; ++i)
+		{
+			vec.push_back(i);
+		}
+		vec.resize(resizeSize, 5);
+
+		if (resizeSize > initialSize)
+		{
+			for (size_t i = initialSize; i < resizeSize; ++i)
+			{
+				assert("Resize did not fill elements with requested default value" && vec[i] == 5);
+			}
+		}
+
+		assert("Vector size did not change as requested" && vec.size() == resizeSize);
+	}
+
+	void ResizeUninitialized()
+	{
+		Vector<int> testVector;
+		testVector.push_back(1);
+		testVector.push_back(2);
+
+		testVector.resize_uninitialized(5000);
+		assert("Vector size did not change as requested" && testVector.size() == 5000u);
+		assert("Vector capacity too small" && testVector.capacity() >= 5000u);
+		assert("Existing elements were touched" && testVector[0] == 1 && testVector[1] == 2);
+
+		testVector.resize_uninitialized(1);
+		assert("Vector size did not change as requested" && testVector.size() == 1u);
+		assert("Existing elements were touched" && testVector[0] == 1);
+	}
+
+	void ResizeZeroed()
+	{
+		// Small dirty range (memset) followed by fresh pages from the OS
+		Vector<size_t> smallVector;
+		smallVector.resize(2500, 0xDEADBEEFu);
+		smallVector.resize(10);
+		smallVector.resize_zeroed(10000);
+
+		assert("Vector size did not change as requested" && smallVector.size() == 10000u);
+		for (size_t i = 0; i < 10; ++i)
+		{
+			assert("Existing elements were touched" && smallVector[i] == 0xDEADBEEFu);
+		}
+		for (size_t i = 10; i < 10000; ++i)
+		{
+			assert("New element was not zeroed" && smallVector[i] == 0u);
+		}
+
+		// Large dirty range, zeroed by decommitting / recommitting the pages
+		Vector<float> largeVector;
+		largeVector.resize(1000000, 1.5f);
+		largeVector.resize(3);
+		largeVector.resize_zeroed(1100000);
+
+		assert("Vector size did not change as requested" && largeVector.size() == 1100000u);
+		for (size_t i = 0; i < 3; ++i)
+		{
+			assert("Existing elements were touched" && largeVector[i] == 1.5f);
+		}
+		for (size_t i = 3; i < 1100000; ++i)
+		{
+			assert("New element was not zeroed" && largeVector[i] == 0.0f);
+		}
+	}
+
+	void ResizeParallel()
+	{
+		Vector<size_t> testVector;
+		testVector.push_back(123u);
+
+		testVector.resize_parallel(2000000, 0xDEADBEEFu);
+		assert("Vector size did not change as requested" && testVector.size() == 2000000u);
+		assert("Existing elements were touched" && testVector[0] == 123u);
+		for (size_t i = 1; i < testVector.size(); ++i)
+		{
+			assert("Resize did not fill elements with requested default value" && testVector[i] == 0xDEADBEEFu);
+		}
+
+		testVector.resize_parallel(10);
+		assert("Vector size did not change as requested" && testVector.size() == 10u);
+
+		// Default initialization of a trivial type only touches the pages, fresh ones stay zero and all are writable
+		Vector<size_t> defaultVector;
+		defaultVector.push_back(7u);
+		defaultVector.resize_parallel(3000000);
+		assert("Vector size did not change as requested" && defaultVector.size() == 3000000u);
+		assert("Existing elements were touched" && defaultVector[0] == 7u);
+		for (size_t i = 1; i < defaultVector.size(); ++i)
+		{
+			assert("Fresh pages are not zero" && defaultVector[i] == 0u);
+			defaultVector[i] = i;
+		}
+		defaultVector.resize_parallel(1000);
+		defaultVector.resize_parallel(2000000);
+		assert("Existing elements were touched" && defaultVector[999] == 999u && defaultVector.size() == 2000000u);
+
+		// Odd sized elements straddle the block borders
+		struct SixByte
+		{
+			uint16_t values[3];
+		};
+		SixByte initializer = { { 1u, 2u, 3u } };
+		Vector<SixByte> oddVector;
+		oddVector.resize_parallel(1000000, initializer);
+		for (size_t i = 0; i < oddVector.size(); ++i)
+		{
+			assert("Resize did not fill elements with requested default value" && oddVector[i].values[0] == 1u && oddVector[i].values[2] == 3u);
+		}
+
+		oddVector.clear_parallel();
+		assert("Vector was not cleared" && oddVector.empty());
+	}
+
+	void EraseSingle()
+	{
+		Vector<size_t> testVector;
+
+		testVector.push_back(123u);
+		testVector.push_back(456u);
+		testVector.push_back(789u);
+		testVector.push_back(123456789u);
+
+		assert(testVector[0] == 123u);
+		assert(testVector[1] == 456u);
+		assert(testVector[2] == 789u);
+		assert(testVector[3] == 123456789u);
+
+		testVector.erase(1);
+
+		assert(testVector[0] == 123u);
+		assert(testVector[1] == 789u);
+		assert(testVector[2] == 123456789u);
+		assert(testVector.size() == 3u);
+	}
+
+	void EraseRange()
+	{
+		Vector<size_t> testVector;
+
+		testVector.push_back(123u);
+		testVector.push_back(456u);
+		testVector.push_back(789u);
+		testVector.push_back(123456789u);
+
+		assert(testVector[0] == 123u);
+		assert(testVector[1] == 456u);
+		assert(testVector[2] == 789u);
+		assert(testVector[3] == 123456789u);
+
+		testVector.erase(1, 2);
+
+		assert(testVector[0] == 123u);
+		assert(testVector[1] == 123456789u);
+		assert(testVector.size() == 2u);
+	}
+
+	void EraseEmptyRange()
+	{
+		Vector<size_t> testVector;
+
+		testVector.push_back(123u);
+		testVector.push_back(456u);
+		testVector.push_back(789u);
+		testVector.push_back(123456789u);
+
+		assert(testVector[0] == 123u);
+		assert(testVector[1] == 456u);
+		assert(testVector[2] == 789u);
+		assert(testVector[3] == 123456789u);
+
+		testVector.erase(1, 1);
+
+		assert(testVector[0] == 123u);
+		assert(testVector[1] == 456u);
+		assert(testVector[2] == 789u);
+		assert(testVector[3] == 123456789u);
+	}
+
+	void EraseBySwap()
+	{
+		Vector<size_t> testVector;
+
+		testVector.push_back(123u);
+		testVector.push_back(456u);
+		testVector.push_back(789u);
+		testVector.push_back(123456789u);
+
+		assert(testVector[0] == 123u);
+		assert(testVector[1] == 456u);
+		assert(testVector[2] == 789u);
+		assert(testVector[3] == 123456789u);
+
+		testVector.erase_by_swap(1);
+
+		assert(testVector[0] == 123u);
+		assert(testVector[1] == 123456789u);
+		assert(testVector[2] == 789u);
+		assert(testVector.size() == 3u);
+	}
+
+	void EraseBySwapBatch()
+	{
+		Vector<size_t> testVector;
+		for (size_t i = 0; i < 10; ++i)
+		{
+			testVector.push_back(i);
+		}
+
+		// 9 and 8 are targets as well as the last elements, they must not be swapped into a hole
+		Vector<size_t> indices;
+		indices.push_back(8u);
+		indices.push_back(2u);
+		indices.push_back(9u);
+		indices.push_back(0u);
+		indices.push_back(2u);
+
+		testVector.erase_by_swap(indices);
+
+		assert("Indices were not sorted and made unique" && indices.size() == 4u && indices[0] == 0u && indices[1] == 2u && indices[2] == 8u && indices[3] == 9u);
+		assert("Vector size mismatch" && testVector.size() == 6u);
+		assert(testVector[0] == 6u);
+		assert(testVector[1] == 1u);
+		assert(testVector[2] == 7u);
+		assert(testVector[3] == 3u);
+		assert(testVector[4] == 4u);
+		assert(testVector[5] == 5u);
+	}
+
+	void EraseIf()
+	{
+		Vector<size_t> testVector;
+		for (size_t i = 0; i < 1000; ++i)
+		{
+			testVector.push_back(i);
+		}
+
+		const size_t erased = testVector.erase_if([](const size_t& value) { return value % 3u == 0u; });
+
+		assert("Erase count mismatch" && erased == 334u);
+		assert("Vector size mismatch" && testVector.size() == 666u);
+		for (size_t i = 0; i < testVector.size(); ++i)
+		{
+			assert("Erased value still in vector" && testVector[i] % 3u != 0u);
+			assert("Order of kept elements changed" && (i == 0 || testVector[i - 1] < testVector[i]));
+		}
+	}
+
+	void EraseIfParallel()
+	{
+		Vector<size_t> serialVector;
+		for (size_t i = 0; i < 100000; ++i)
+		{
+			serialVector.push_back(i * 7u);
+		}
+		Vector<size_t> parallelVector(serialVector);
+
+		auto predicate = [](const size_t& value) { return value % 5u < 2u; };
+		const size_t serialErased = serialVector.erase_if(predicate);
+		const size_t parallelErased = parallelVector.erase_if_parallel(predicate);
+
+		assert("Erase count mismatch" && serialErased == parallelErased);
+		assert("Vector size mismatch" && serialVector.size() == parallelVector.size());
+		for (size_t i = 0; i < serialVector.size(); ++i)
+		{
+			assert("Vector value mismatch" && serialVector[i] == parallelVector[i]);
+		}
+	}
+
+	void EraseIndices()
+	{
+		Vector<size_t> testVector;
+		for (size_t i = 0; i < 10; ++i)
+		{
+			testVector.push_back(i);
+		}
+
+		Vector<size_t> indices;
+		indices.push_back(0u);
+		indices.push_back(3u);
+		indices.push_back(4u);
+		indices.push_back(9u);
+
+		testVector.erase_indices(indices);
+
+		assert("Vector size mismatch" && testVector.size() == 6u);
+		assert(testVector[0] == 1u);
+		assert(testVector[1] == 2u);
+		assert(testVector[2] == 5u);
+		assert(testVector[3] == 6u);
+		assert(testVector[4] == 7u);
+		assert(testVector[5] == 8u);
+	}
+
+	void InsertSingle()
+	{
+		Vector<size_t> testVector;
+
+		testVector.push_back(123u);
+		testVector.push_back(789u);
+
+		testVector.insert(1, 456u);
+		testVector.insert(0, 12u);
+		testVector.insert(testVector.size(), 123456789u);
+
+		assert(testVector.size() == 5u);
+		assert(testVector[0] == 12u);
+		assert(testVector[1] == 123u);
+		assert(testVector[2] == 456u);
+		assert(testVector[3] == 789u);
+		assert(testVector[4] == 123456789u);
+	}
+
+	void InsertMultiple()
+	{
+		Vector<size_t> testVector;
+
+		for (size_t i = 0; i < 1000; ++i)
+		{
+			testVector.push_back(i);
+		}
+
+		// Inserting copies of an element of the vector itself must not read the already shifted slot
+		testVector.insert(10, 2000, testVector[500]);
+
+		assert("Vector size mismatch" && testVector.size() == 3000u);
+		for (size_t i = 0; i < 10; ++i)
+		{
+			assert("Vector value mismatch" && testVector[i] == i);
+		}
+		for (size_t i = 10; i < 2010; ++i)
+		{
+			assert("Inserted value mismatch" && testVector[i] == 500u);
+		}
+		for (size_t i = 2010; i < 3000; ++i)
+		{
+			assert("Vector value mismatch" && testVector[i] == i - 2000);
+		}
+	}
+
+	void InsertRange()
+	{
+		Vector<int> testVector;
+		testVector.push_back(1);
+		testVector.push_back(5);
+
+		const int values[] = { 2, 3, 4 };
+		testVector.insert(1, values, values + 3);
+
+		assert("Vector size mismatch" && testVector.size() == 5u);
+		for (size_t i = 0; i < 5; ++i)
+		{
+			assert("Vector value mismatch" && testVector[i] == static_cast<int>(i) + 1);
+		}
+
+		// Empty ranges are a no-op
+		testVector.insert(2, values, values);
+		assert("Vector size mismatch" && testVector.size() == 5u);
+	}
+
+	void FrontBackPopBack()
+	{
+		Vector<size_t> testVector;
+		testVector.push_back(123u);
+		testVector.push_back(456u);
+		testVector.push_back(789u);
+
+		assert("Front element mismatch" && testVector.front() == 123u);
+		assert("Back element mismatch" && testVector.back() == 789u);
+
+		testVector.pop_back();
+		assert("Vector size mismatch" && testVector.size() == 2u);
+		assert("Back element mismatch" && testVector.back() == 456u);
+
+		testVector.back() = 42u;
+		assert("Back is not a reference" && testVector[1] == 42u);
+	}
+
+	void IteratorsAndData()
+	{
+		Vector<int> testVector;
+		for (int i = 0; i < 1000; ++i)
+		{
+			testVector.push_back(999 - i);
+		}
+
+		assert("Data is not page aligned" && reinterpret_cast<uintptr_t>(testVector.data()) % 4096u == 0u);
+		assert("Data does not point to the first element" && testVector.data() == &testVector[0]);
+		assert("Iterator range does not match the size" && static_cast<size_t>(testVector.end() - testVector.begin()) == testVector.size());
+
+		std::sort(testVector.begin(), testVector.end());
+		int expected = 0;
+		for (const int value : testVector)
+		{
+			assert("Vector was not sorted" && value == expected);
+			++expected;
+		}
+
+		const Vector<int>& constVector = testVector;
+		std::transform(constVector.begin(), constVector.end(), testVector.begin(), [](int value) { return value * 2; });
+		assert("Transform did not write through the iterators" && testVector[10] == 20);
+	}
+
+	void ParallelForAndReduce()
+	{
+		Vector<size_t> testVector;
+		testVector.resize_uninitialized(3000000);
+		for (size_t i = 0; i < testVector.size(); ++i)
+		{
+			testVector[i] = i;
+		}
+
+		parallel_for(testVector, [](size_t& value) { value *= 2u; });
+		for (size_t i = 0; i < testVector.size(); ++i)
+		{
+			assert("parallel_for did not visit every element once" && testVector[i] == i * 2u);
+		}
+
+		const size_t count = testVector.size();
+		const size_t sum = parallel_reduce(testVector, size_t(5u), [](size_t a, size_t b) { return a + b; });
+		assert("parallel_reduce sum mismatch" && sum == count * (count - 1u) + 5u);
+
+		const size_t maximum = parallel_reduce(testVector, size_t(0u), [](size_t a, size_t b) { return a > b ? a : b; });
+		assert("parallel_reduce max mismatch" && maximum == (count - 1u) * 2u);
+
+		Vector<size_t> emptyVector;
+		assert("Reducing an empty vector does not return init" && parallel_reduce(emptyVector, size_t(42u), [](size_t a, size_t b) { return a + b; }) == 42u);
+	}
+
+	void ThreadPoolNestedRun()
+	{
+		// Tasks that start parallel work themselves must not dead lock the pool
+		Vector<size_t> results;
+		results.resize_zeroed(16);
+		size_t* const resultData = results.data();
+		Parallel::ForEachBlock(16, [resultData](size_t outer)
+		{
+			std::atomic<size_t> innerSum(0u);
+			Parallel::ForEachBlock(100, [&innerSum](size_t inner) { innerSum += inner; });
+			resultData[outer] = innerSum.load();
+		});
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			assert("Nested parallel work was lost" && results[i] == 4950u);
+		}
+	}
+
+	// Small xorshift generator, the tests need reproducible pseudo random numbers
+	uint64_t NextRandom(uint64_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+
+	template <typename T, typename Generator>
+	void CheckRadixSort(size_t count, Generator generator)
+	{
+		Vector<T> testVector;
+		for (size_t i = 0; i < count; ++i)
+		{
+			testVector.push_back(generator(i));
+		}
+		Vector<T> expected(testVector);
+		std::sort(expected.begin(), expected.end());
+
+		radix_sort(testVector);
+
+		assert("Vector size mismatch" && testVector.size() == expected.size());
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert("radix_sort result mismatch" && std::memcmp(&testVector[i], &expected[i], sizeof(T)) == 0);
+		}
+	}
+
+	void RadixSort()
+	{
+		uint64_t state = 88172645463325252ull;
+		CheckRadixSort<int>(500000, [&state](size_t) { return static_cast<int>(NextRandom(state)); });
+		CheckRadixSort<uint64_t>(300000, [&state](size_t) { return NextRandom(state); });
+		CheckRadixSort<int16_t>(1000, [&state](size_t) { return static_cast<int16_t>(NextRandom(state)); });
+		CheckRadixSort<size_t>(200000, [](size_t i) { return i % 7u; });
+		CheckRadixSort<float>(200000, [&state](size_t) { return static_cast<float>(static_cast<int64_t>(NextRandom(state) % 2000001u) - 1000000) / 7.0f; });
+		CheckRadixSort<double>(200000, [&state](size_t) { return static_cast<double>(static_cast<int64_t>(NextRandom(state))) * 1e-3; });
+	}
+
+	void ParallelSort()
+	{
+		uint64_t state = 2463534242ull;
+		Vector<size_t> testVector;
+		for (size_t i = 0; i < 1000000; ++i)
+		{
+			testVector.push_back(NextRandom(state) % 100000u);
+		}
+		Vector<size_t> expected(testVector);
+		std::sort(expected.begin(), expected.end(), std::greater<size_t>());
+
+		parallel_sort(testVector, std::greater<size_t>());
+		for (size_t i = 0; i < testVector.size(); ++i)
+		{
+			assert("parallel_sort result mismatch" && testVector[i] == expected[i]);
+		}
+	}
+
+	template <typename T>
+	void CheckSimdKernels(Simd::InstructionSet instructionSet, size_t count)
+	{
+		Vector<T> testVector;
+		for (size_t i = 0; i < count; ++i)
+		{
+			// Small values, so neither the integer nor the float sums depend on the order of the adds
+			testVector.push_back(static_cast<T>((i * 37u) % 101u) - static_cast<T>(std::is_signed<T>::value ? 50 : 0));
+		}
+		const T* const elements = testVector.data();
+
+		T expectedSum = T(0);
+		for (size_t i = 0; i < count; ++i)
+		{
+			expectedSum += elements[i];
+		}
+		assert("Sum kernel mismatch" && Simd::Run<Simd::SumKernel>(instructionSet, elements, count) == expectedSum);
+
+		if (count > 0)
+		{
+			assert("Min kernel mismatch" && Simd::Run<Simd::MinKernel>(instructionSet, elements, count) == *std::min_element(elements, elements + count));
+			assert("Max kernel mismatch" && Simd::Run<Simd::MaxKernel>(instructionSet, elements, count) == *std::max_element(elements, elements + count));
+		}
+
+		const T value = count > 0 ? elements[count / 2] : T(7);
+		assert("Count kernel mismatch" && Simd::Run<Simd::CountEqualKernel>(instructionSet, elements, count, value) == static_cast<size_t>(std::count(elements, elements + count, value)));
+		assert("Find kernel mismatch" && Simd::Run<Simd::FindEqualKernel>(instructionSet, elements, count, value) == static_cast<size_t>(std::find(elements, elements + count, value) - elements));
+		assert("Find kernel found a missing value" && Simd::Run<Simd::FindEqualKernel>(instructionSet, elements, count, T(1000)) == count);
+	}
+
+	template <typename T>
+	void CheckSimdKernels(Simd::InstructionSet instructionSet)
+	{
+		for (size_t count = 0; count < 100; ++count)
+		{
+			CheckSimdKernels<T>(instructionSet, count);
+		}
+		CheckSimdKernels<T>(instructionSet, 100003);
+	}
+
+	void SimdKernels()
+	{
+		const Simd::InstructionSet instructionSets[] = { Simd::InstructionSet::Sse2, Simd::InstructionSet::Avx2, Simd::InstructionSet::Avx512 };
+		for (const Simd::InstructionSet instructionSet : instructionSets)
+		{
+			if (static_cast<int>(instructionSet) > static_cast<int>(Simd::GetInstructionSet()))
+			{
+				break;
+			}
+			CheckSimdKernels<int32_t>(instructionSet);
+			CheckSimdKernels<uint32_t>(instructionSet);
+			CheckSimdKernels<int64_t>(instructionSet);
+			CheckSimdKernels<uint64_t>(instructionSet);
+			CheckSimdKernels<float>(instructionSet);
+			CheckSimdKernels<double>(instructionSet);
+		}
+
+		// Large enough for the parallel path, the extremes and the searched value sit at the very end
+		const size_t count = 3 * 1024 * 1024;
+		Vector<int> testVector;
+		testVector.resize(count, 1);
+		testVector[count - 2] = -5;
+		testVector[count - 1] = 9;
+		assert("simd_sum mismatch" && simd_sum(testVector) == static_cast<int>(count - 2) + 4);
+		assert("simd_min mismatch" && simd_min(testVector) == -5);
+		assert("simd_max mismatch" && simd_max(testVector) == 9);
+		assert("simd_count_if_equal mismatch" && simd_count_if_equal(testVector, 1) == count - 2);
+		assert("simd_find mismatch" && simd_find(testVector, 9) == testVector.begin() + (count - 1));
+		assert("simd_any_of mismatch" && simd_any_of(testVector, -5) && !simd_any_of(testVector, 2));
+
+		Vector<double> emptyVector;
+		assert("simd_sum of an empty vector is not 0" && simd_sum(emptyVector) == 0.0);
+		assert("simd_find in an empty vector is not end" && simd_find(emptyVector, 1.0) == emptyVector.end());
+	}
+
+	void ExpressionTemplates()
+	{
+		const size_t count = 1003;
+		Vector<float> a;
+		Vector<float> b;
+		for (size_t i = 0; i < count; ++i)
+		{
+			a.push_back(static_cast<float>(i));
+			b.push_back(static_cast<float>(i % 10));
+		}
+
+		Vector<float> result = a * 2.0f + b;
+		assert("Vector size mismatch" && result.size() == count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert("Fused multiply add mismatch" && result[i] == a[i] * 2.0f + b[i]);
+		}
+
+		result = (a + b) * (a - b) / 2 - 1.0f;
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert("Chained expression mismatch" && result[i] == (a[i] + b[i]) * (a[i] - b[i]) / 2.0f - 1.0f);
+		}
+
+		result = map(a + 1.0f, [](float x) { return x * x; });
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert("map mismatch" && result[i] == (a[i] + 1.0f) * (a[i] + 1.0f));
+		}
+
+		result = zip(a, b * 100.0f, [](float x, float y) { return x > y ? x : y; });
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert("zip mismatch" && result[i] == (a[i] > b[i] * 100.0f ? a[i] : b[i] * 100.0f));
+		}
+
+		// The target may be one of the operands
+		a = 1.0f - a * 0.5f;
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert("Aliased expression mismatch" && a[i] == 1.0f - static_cast<float>(i) * 0.5f);
+		}
+
+		Vector<int> integers;
+		for (int i = 0; i < 100; ++i)
+		{
+			integers.push_back(i);
+		}
+		Vector<int> integerResult = integers * 3 - integers / 2;
+		for (int i = 0; i < 100; ++i)
+		{
+			assert("Integer expression mismatch" && integerResult[i] == i * 3 - i / 2);
+		}
+
+		// Large enough for the parallel evaluation
+		const size_t largeCount = 2 * 1024 * 1024;
+		Vector<double> x;
+		x.resize(largeCount, 3.0);
+		Vector<double> y;
+		y.resize(largeCount, 0.5);
+		Vector<double> z = x * y + x / y;
+		assert("Vector size mismatch" && z.size() == largeCount);
+		for (size_t i = 0; i < largeCount; i += 4093)
+		{
+			assert("Parallel expression mismatch" && z[i] == 7.5);
+		}
+		assert("Parallel expression mismatch" && z[largeCount - 1] == 7.5);
+	}
+
+	void GatherScatter()
+	{
+		uint64_t state = 1181783497276652981ull;
+		const size_t count = 100003;
+		Vector<float> source;
+		Vector<uint64_t> wideSource;
+		Vector<int16_t> narrowSource;
+		for (size_t i = 0; i < count; ++i)
+		{
+			source.push_back(static_cast<float>(i) * 0.25f);
+			wideSource.push_back(i * 3u);
+			narrowSource.push_back(static_cast<int16_t>(i));
+		}
+
+		// A random permutation, as 32 and 64 bit indices
+		Vector<size_t> permutation;
+		for (size_t i = 0; i < count; ++i)
+		{
+			permutation.push_back(i);
+		}
+		for (size_t i = count - 1; i > 0; --i)
+		{
+			std::swap(permutation[i], permutation[NextRandom(state) % (i + 1)]);
+		}
+		Vector<uint32_t> narrowPermutation;
+		for (size_t i = 0; i < count; ++i)
+		{
+			narrowPermutation.push_back(static_cast<uint32_t>(permutation[i]));
+		}
+
+		Vector<float> gathered;
+		gather(source, permutation, gathered);
+		assert("Vector size mismatch" && gathered.size() == count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert("Gather mismatch" && gathered[i] == source[permutation[i]]);
+		}
+
+		Vector<uint64_t> wideGathered;
+		gather(wideSource, narrowPermutation, wideGathered, 8);
+		Vector<int16_t> narrowGathered;
+		gather(narrowSource, narrowPermutation, narrowGathered);
+		Vector<float> narrowIndexGathered;
+		gather(source, narrowPermutation, narrowIndexGathered, 0);
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert("Gather mismatch" && wideGathered[i] == wideSource[permutation[i]]);
+			assert("Gather mismatch" && narrowGathered[i] == narrowSource[permutation[i]]);
+			assert("Gather mismatch" && narrowIndexGathered[i] == source[permutation[i]]);
+		}
+
+		// Scattering the gathered elements back with the same permutation restores the source
+		Vector<float> restored;
+		restored.resize(count, -1.0f);
+		scatter(gathered, permutation, restored);
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert("Scatter mismatch" && restored[i] == source[i]);
+		}
+
+		// Large enough for the parallel gather, indices pick every 7th element
+		const size_t largeCount = 2 * 1024 * 1024;
+		Vector<uint32_t> strided;
+		for (size_t i = 0; i < largeCount; ++i)
+		{
+			strided.push_back(static_cast<uint32_t>((i * 7u) % count));
+		}
+		gather(wideSource, strided, wideGathered);
+		assert("Vector size mismatch" && wideGathered.size() == largeCount);
+		for (size_t i = 0; i < largeCount; ++i)
+		{
+			assert("Parallel gather mismatch" && wideGathered[i] == wideSource[strided[i]]);
+		}
+	}
+
+	void Comparisons()
+	{
+		Vector<int> a;
+		Vector<int> b;
+		for (int i = 0; i < 1000; ++i)
+		{
+			a.push_back(i - 500);
+			b.push_back(i - 500);
+		}
+		assert("Equal vectors compare unequal" && a == b && !(a != b) && !(a < b) && a <= b && a >= b);
+		assert("mismatch of equal vectors" && mismatch(a, b) == 1000);
+
+		const size_t positions[] = { 0, 15, 16, 63, 64, 500, 999 };
+		for (const size_t position : positions)
+		{
+			b[position] += 1;
+			assert("mismatch position" && mismatch(a, b) == position);
+			assert("Different vectors compare equal" && a != b && a < b && b > a && !(b <= a));
+			b[position] -= 1;
+		}
 
-		Vector<size_t> largeVector;
-		largeVector.push_back(312u);
-		largeVector.push_back(654u);
-		largeVector.push_back(987u);
-		largeVector.push_back(121110u);
-		largeVector.push_back(151413u);
-		largeVector.push_back(181716u);
-		largeVector.push_back(212019u);
-		largeVector.push_back(242322u);
-		largeVector.push_back(272625u);
+		// Negative values are ordered by value, not by their bytes
+		b[10] = 1000;
+		a[10] = -1000;
+		assert("Lexicographic order mismatch" && a < b);
+		a[10] = b[10];
+
+		// A prefix is smaller
+		b.push_back(0);
+		assert("Prefix order mismatch" && a < b && a != b && mismatch(a, b) == 1000);
+
+		// Floats compare by value: 0.0f == -0.0f
+		Vector<float> zeros;
+		zeros.push_back(0.0f);
+		Vector<float> negativeZeros;
+		negativeZeros.push_back(-0.0f);
+		assert("Float comparison mismatch" && zeros == negativeZeros);
+
+		// Large enough for the parallel comparison
+		const size_t count = 4 * 1024 * 1024;
+		Vector<uint32_t> large;
+		large.resize(count, 7u);
+		Vector<uint32_t> largeCopy(large);
+		assert("Large equal vectors compare unequal" && large == largeCopy);
+		largeCopy[count - 1] = 8u;
+		assert("Large mismatch position" && mismatch(large, largeCopy) == count - 1 && large < largeCopy);
+		largeCopy[count / 3] = 6u;
+		assert("Large mismatch position" && mismatch(large, largeCopy) == count / 3 && largeCopy < large);
+	}
 
-		// test assignment of larger vector
-		mediumVector = largeVector;
-		assert("Vector size mismatch" && mediumVector.size() == largeVector.size());
-		assert("Vector capacity mismatch" && mediumVector.capacity() == largeVector.capacity());
+	void ContentHash()
+	{
+		// Reference values of XXH64 with seed 0
+		assert("Hash of no bytes" && Hashing::HashBytes("", 0, 0) == 0xEF46DB3751D8E999ull);
+		assert("Hash of abc" && Hashing::HashBytes("abc", 3, 0) == 0x44BC2CF5AD770999ull);
 
-		assert(mediumVector[0] == 312u);
-		assert(mediumVector[1] == 654u);
-		assert(mediumVector[2] == 987u);
-		assert(mediumVector[3] == 121110u);
-		assert(mediumVector[4] == 151413u);
-		assert(mediumVector[5] == 181716u);
-		assert(mediumVector[6] == 212019u);
-		assert(mediumVector[7] == 242322u);
-		assert(mediumVector[8] == 272625u);
+		Vector<uint64_t> a;
+		for (uint64_t i = 0; i < 1000; ++i)
+		{
+			a.push_back(i * i);
+		}
+		Vector<uint64_t> b(a);
+		assert("Equal vectors hash differently" && content_hash(a) == content_hash(b));
+		b[999] ^= 1u;
+		assert("Different vectors hash equally" && content_hash(a) != content_hash(b));
+		b.pop_back();
+		assert("Prefix hashes equally" && content_hash(a) != content_hash(b));
+
+		// Large enough for the chunked hash
+		Vector<uint32_t> large;
+		large.resize(3 * 1024 * 1024 + 5, 3u);
+		const uint64_t largeHash = content_hash(large);
+		assert("Chunked hash is not deterministic" && content_hash(large) == largeHash);
+		large[2 * 1024 * 1024] = 4u;
+		assert("Chunked hash missed a change" && content_hash(large) != largeHash);
+	}
 
-		// test assignment of smaller vector
-		largeVector = smallVector;
-		assert("Vector size mismatch" && largeVector.size() == smallVector.size());
-		assert("Vector capacity mismatch" && largeVector.capacity() == smallVector.capacity());
+	template <typename T>
+	void CheckScans(size_t count)
+	{
+		Vector<T> inclusive;
+		for (size_t i = 0; i < count; ++i)
+		{
+			inclusive.push_back(static_cast<T>(i % 13));
+		}
+		Vector<T> exclusive(inclusive);
+		Vector<T> original(inclusive);
 
-		assert(smallVector[0] == 123u);
-		assert(smallVector[1] == 456u);
-		assert(smallVector[2] == 789u);
+		inclusive_scan(inclusive);
+		exclusive_scan(exclusive, T(5));
+
+		T sum = T(0);
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert("exclusive_scan mismatch" && exclusive[i] == sum + T(5));
+			sum += original[i];
+			assert("inclusive_scan mismatch" && inclusive[i] == sum);
+		}
 	}
 
-	void PushBack()
+	void Scans()
 	{
-		Vector<size_t> firstVec;
+		for (size_t count = 0; count < 40; ++count)
+		{
+			CheckScans<uint32_t>(count);
+			CheckScans<int64_t>(count);
+			CheckScans<float>(count);
+			CheckScans<double>(count);
+			CheckScans<int16_t>(count);
+		}
 
-		for (size_t i = 0; i < 5; ++i)
+		// Large enough for the two pass scan, the float sums stay exact below 2^24
+		CheckScans<uint32_t>(3 * 1024 * 1024 + 7);
+		CheckScans<double>(1024 * 1024 + 3);
+		CheckScans<float>(1024 * 1024 + 3);
+
+		// A custom operation without identity: the running maximum
+		const size_t count = 2 * 1024 * 1024;
+		Vector<size_t> maxima;
+		for (size_t i = 0; i < count; ++i)
 		{
-			firstVec.push_back(i);
+			maxima.push_back((i * 7919u) % 1000003u);
+		}
+		Vector<size_t> expected(maxima);
+		for (size_t i = 1; i < count; ++i)
+		{
+			expected[i] = expected[i] > expected[i - 1] ? expected[i] : expected[i - 1];
 		}
+		inclusive_scan(maxima, [](size_t a, size_t b) { return a > b ? a : b; });
+		assert("Custom inclusive_scan mismatch" && maxima == expected);
+	}
 
-		assert("Size should equal 5" && firstVec.size() == 5);
+	template <typename T>
+	Vector<T> RandomSortedSet(uint64_t& state, size_t count, uint64_t range)
+	{
+		Vector<T> set;
+		for (size_t i = 0; i < count; ++i)
+		{
+			set.push_back(static_cast<T>(NextRandom(state) % range));
+		}
+		std::sort(set.begin(), set.end());
+		set.resize(static_cast<size_t>(std::unique(set.begin(), set.end()) - set.begin()));
+		return set;
+	}
 
-		for (size_t i = 0; i < 5; ++i)
+	template <typename T>
+	void CheckSetOperations(const Vector<T>& left, const Vector<T>& right)
+	{
+		Vector<T> result;
+		Vector<T> expected;
+
+		set_intersection(left, right, result);
+		std::set_intersection(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(expected));
+		assert("set_intersection mismatch" && result == expected);
+
+		expected.resize(0);
+		set_union(left, right, result);
+		std::set_union(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(expected));
+		assert("set_union mismatch" && result == expected);
+
+		expected.resize(0);
+		set_difference(left, right, result);
+		std::set_difference(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(expected));
+		assert("set_difference mismatch" && result == expected);
+	}
+
+	void SortedSetOperations()
+	{
+		uint64_t state = 6364136223846793005ull;
+		const size_t sizes[] = { 0, 1, 3, 4, 5, 17, 100, 1000, 50000 };
+		for (const size_t leftSize : sizes)
 		{
-			assert("Vector value mismatch" && firstVec[i] == i);
+			for (const size_t rightSize : sizes)
+			{
+				// Dense ranges give many matches, the galloping path kicks in for the skewed sizes
+				const Vector<uint32_t> left = RandomSortedSet<uint32_t>(state, leftSize, 2 * (leftSize + rightSize) + 1);
+				const Vector<uint32_t> right = RandomSortedSet<uint32_t>(state, rightSize, 2 * (leftSize + rightSize) + 1);
+				CheckSetOperations(left, right);
+				CheckSetOperations(right, left);
+				CheckSetOperations(left, left);
+
+				const Vector<int64_t> wideLeft = RandomSortedSet<int64_t>(state, leftSize, 3 * (leftSize + rightSize) + 1);
+				const Vector<int64_t> wideRight = RandomSortedSet<int64_t>(state, rightSize, 3 * (leftSize + rightSize) + 1);
+				CheckSetOperations(wideLeft, wideRight);
+			}
 		}
 	}
 
-	void PushBackDepleteResources()
+	void FlatSetOperations()
 	{
-		Vector<size_t> v;
+		uint64_t state = 3935559000370003845ull;
+		Vector<int> keys;
+		for (size_t i = 0; i < 20000; ++i)
+		{
+			keys.push_back(static_cast<int>(NextRandom(state) % 10000u) - 5000);
+		}
+		Vector<int> expected(keys);
+		std::sort(expected.begin(), expected.end());
+		expected.resize(static_cast<size_t>(std::unique(expected.begin(), expected.end()) - expected.begin()));
+
+		FlatSet<int> set;
+		set.build(keys);
+		assert("FlatSet build mismatch" && set.keys() == expected);
+		for (int key = -5001; key <= 5000; ++key)
+		{
+			assert("FlatSet lookup mismatch" && set.contains(key) == std::binary_search(expected.begin(), expected.end(), key));
+		}
 
-		// Vector can hold 134217727 size_ts on 64 bit in 1GB mem
-		for (size_t i = 0; i < 134217728; ++i)
+		assert("FlatSet insert of a missing key failed" && set.insert(7777) && set.contains(7777));
+		assert("FlatSet insert of a present key succeeded" && !set.insert(7777));
+		assert("FlatSet erase failed" && set.erase(7777) && !set.contains(7777) && !set.erase(7777));
+
+		// A batch with duplicates, keys that are present already and keys outside the current range
+		Vector<int> batch;
+		for (size_t i = 0; i < 5000; ++i)
 		{
-			v.push_back(0u);
+			batch.push_back(static_cast<int>(NextRandom(state) % 30000u) - 15000);
 		}
+		set.insert_batch(batch);
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			expected.push_back(batch[i]);
+		}
+		std::sort(expected.begin(), expected.end());
+		expected.resize(static_cast<size_t>(std::unique(expected.begin(), expected.end()) - expected.begin()));
+		assert("FlatSet insert_batch mismatch" && set.keys() == expected);
+
+		FlatSet<int, std::greater<int>> descending;
+		descending.build(keys);
+		assert("FlatSet order mismatch" && *descending.begin() > *(descending.end() - 1) && descending.contains(keys[0]));
+		descending.insert_batch(batch);
+		assert("FlatSet order mismatch" && std::is_sorted(descending.begin(), descending.end(), std::greater<int>()));
+		assert("FlatSet insert_batch size mismatch" && descending.size() == expected.size());
+	}
 
-		// Pushing another element would exceed the available address space and asserts
-		v.push_back(666u);
+	void FlatMapOperations()
+	{
+		Vector<uint32_t> keys;
+		Vector<uint64_t> values;
+		for (uint32_t i = 0; i < 10000; ++i)
+		{
+			// Every key shows up twice, the first value wins
+			keys.push_back((i * 7919u) % 5000u);
+			values.push_back(i);
+		}
+
+		FlatMap<uint32_t, uint64_t> map;
+		map.build(keys, values);
+		assert("FlatMap size mismatch" && map.size() == 5000);
+		for (uint32_t i = 0; i < 5000; ++i)
+		{
+			const uint32_t key = (i * 7919u) % 5000u;
+			assert("FlatMap lookup mismatch" && map.find(key) != nullptr && *map.find(key) == i);
+		}
+		assert("FlatMap found a missing key" && map.find(5000) == nullptr);
+
+		map[6000] = 42;
+		assert("FlatMap operator[] mismatch" && map.contains(6000) && map[6000] == 42 && map.size() == 5001);
+		assert("FlatMap insert overwrote a value" && !map.insert(6000, 1) && map[6000] == 42);
+		assert("FlatMap erase failed" && map.erase(6000) && !map.contains(6000));
+
+		Vector<uint32_t> batchKeys;
+		Vector<uint64_t> batchValues;
+		for (uint32_t i = 0; i < 2000; ++i)
+		{
+			batchKeys.push_back(4000 + i);
+			batchValues.push_back(1000000 + i);
+		}
+		map.insert_batch(batchKeys, batchValues);
+		assert("FlatMap insert_batch size mismatch" && map.size() == 6000);
+		for (uint32_t key = 0; key < 6000; ++key)
+		{
+			const uint64_t* value = map.find(key);
+			assert("FlatMap insert_batch lost a key" && value != nullptr);
+			if (key >= 5000)
+			{
+				assert("FlatMap insert_batch value mismatch" && *value == 1000000 + key - 4000);
+			}
+		}
+		assert("FlatMap keys are not sorted" && std::is_sorted(map.keys().begin(), map.keys().end()));
 	}
 
-	void Reserve()
+	void EytzingerLookups()
 	{
-		Vector<int> vec;
-		// We want to reserve spce for 100 ints (100 * 4 = 400 bytes mem), because we use VirtualMem
-		// we can only allocate in page size chunks and will reserve here at least 4KB (4096 bytes) mem, so the
-		// capacity shall be 1024 after the reserve call
-		vec.reserve(100);
-		assert("Capacity did not match the expected grow behaviour" && vec.capacity() == 1024);
+		for (size_t count = 0; count < 70; ++count)
+		{
+			Vector<int> sorted;
+			for (size_t i = 0; i < count; ++i)
+			{
+				sorted.push_back(static_cast<int>(i / 2) * 2);
+			}
+			EytzingerIndex<int> index;
+			index.build(sorted);
+			for (int key = -1; key <= static_cast<int>(count) + 1; ++key)
+			{
+				const size_t expected = static_cast<size_t>(std::lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin());
+				assert("EytzingerIndex lower_bound mismatch" && index.lower_bound(key) == expected);
+				assert("EytzingerIndex contains mismatch" && index.contains(key) == std::binary_search(sorted.begin(), sorted.end(), key));
+			}
+		}
+
+		// Big enough for the parallel build and the parallel batch
+		uint64_t state = 8246394782311211347ull;
+		Vector<uint64_t> sorted;
+		for (size_t i = 0; i < 1500000; ++i)
+		{
+			sorted.push_back(NextRandom(state) % 100000000u);
+		}
+		radix_sort(sorted);
+		EytzingerIndex<uint64_t> index;
+		index.build(sorted);
+
+		Vector<uint64_t> keys;
+		for (size_t i = 0; i < 100000; ++i)
+		{
+			keys.push_back(i % 4 == 0 ? sorted[NextRandom(state) % sorted.size()] : NextRandom(state) % 100001000u);
+		}
+		Vector<size_t> ranks;
+		index.lower_bound_batch(keys, ranks);
+		assert("EytzingerIndex batch size mismatch" && ranks.size() == keys.size());
+		for (size_t i = 0; i < keys.size(); ++i)
+		{
+			const size_t expected = static_cast<size_t>(std::lower_bound(sorted.begin(), sorted.end(), keys[i]) - sorted.begin());
+			assert("EytzingerIndex batch mismatch" && ranks[i] == expected && index.lower_bound(keys[i]) == expected);
+		}
 	}
 
-	void TooBigReserve()
+	void FlatHashMapOperations()
 	{
-		Vector<size_t> v;
-		// 1GB on 64bit could hold 134217728 size_ts
-		v.reserve(134217729); // A reserve request that would exceed the max_capacity asserts
+		FlatHashMap<uint64_t, uint64_t> map;
+		assert("FlatHashMap should start empty" && map.empty() && map.find(1) == nullptr && !map.erase(1));
+
+		bool sawMigration = false;
+		for (uint64_t i = 0; i < 100000; ++i)
+		{
+			assert("FlatHashMap insert failed" && map.insert(i * 2654435761u, i));
+			sawMigration = sawMigration || map.is_migrating();
+			// Every key has to stay visible while the old table is migrated
+			if (i % 997 == 0)
+			{
+				for (uint64_t j = 0; j <= i; j += 101)
+				{
+					assert("FlatHashMap lost a key" && map.find(j * 2654435761u) != nullptr && *map.find(j * 2654435761u) == j);
+				}
+			}
+		}
+		assert("FlatHashMap never migrated" && sawMigration);
+		assert("FlatHashMap size mismatch" && map.size() == 100000);
+		assert("FlatHashMap insert overwrote a value" && !map.insert(0, 5) && *map.find(0) == 0);
+
+		for (uint64_t i = 0; i < 100000; i += 2)
+		{
+			assert("FlatHashMap erase failed" && map.erase(i * 2654435761u));
+		}
+		assert("FlatHashMap size mismatch after erase" && map.size() == 50000);
+		for (uint64_t i = 0; i < 100000; ++i)
+		{
+			assert("FlatHashMap erase mismatch" && map.contains(i * 2654435761u) == (i % 2 == 1));
+		}
+
+		// Reinserting over the tombstones
+		for (uint64_t i = 0; i < 100000; i += 2)
+		{
+			map[i * 2654435761u] = i + 1;
+		}
+		for (uint64_t i = 0; i < 100000; ++i)
+		{
+			assert("FlatHashMap value mismatch" && map[i * 2654435761u] == (i % 2 == 1 ? i : i + 1));
+		}
+
+		map.clear();
+		assert("FlatHashMap clear failed" && map.empty() && !map.contains(2654435761u));
+		map[7] = 8;
+		assert("FlatHashMap reuse after clear failed" && map.size() == 1 && map[7] == 8);
 	}
 
-	void ResizeDefaultCtor(size_t initialSize, size_t resizeSize)
+	template <size_t D>
+	void CheckPriorityQueue(size_t count)
 	{
-		Vector<size_t> vec;
-		for (size_t i = 0; i < initialSize; ++i)
+		uint64_t state = 1442695040888963407ull + count;
+		Vector<uint64_t> elements;
+		for (size_t i = 0; i < count; ++i)
 		{
-			vec.push_back(i);
+			elements.push_back(NextRandom(state) % (count + 1));
 		}
-		vec.resize(resizeSize);
-		assert("Vector size did not changed as requested" && vec.size() == resizeSize);
+		Vector<uint64_t> expected(elements);
+		std::sort(expected.begin(), expected.end(), std::greater<uint64_t>());
+
+		PriorityQueue<uint64_t, std::less<uint64_t>, D> queue;
+		queue.heapify(elements);
+		assert("PriorityQueue size mismatch" && queue.size() == count);
+		// The first child group has to start on a D * 8 byte boundary
+		assert("PriorityQueue child groups are not aligned" && (count == 0 || reinterpret_cast<uintptr_t>(&queue.top() + 1) % (D * sizeof(uint64_t)) == 0));
+
+		Vector<uint64_t> popped;
+		queue.pop_many(count / 2, popped);
+		while (!queue.empty())
+		{
+			popped.push_back(queue.top());
+			queue.pop();
+		}
+		assert("PriorityQueue heapify order mismatch" && popped == expected);
+
+		// push_many into an empty queue rebuilds, into a bigger one pushes one by one
+		queue.push_many(elements);
+		Vector<uint64_t> half;
+		for (size_t i = 0; i < count / 2; ++i)
+		{
+			half.push_back(elements[i]);
+			expected.push_back(elements[i]);
+		}
+		queue.push_many(half);
+		std::sort(expected.begin(), expected.end(), std::greater<uint64_t>());
+		popped.resize(0);
+		queue.pop_many(queue.size() + 10, popped);
+		assert("PriorityQueue push_many order mismatch" && popped == expected && queue.empty());
 	}
 
-	void ResizeBigDefaultCtor()
+	void PriorityQueues()
 	{
-		Vector<int> testVector;
-		testVector.resize(2500, 0xDEADBEEF);
+		CheckPriorityQueue<2>(1000);
+		CheckPriorityQueue<4>(0);
+		CheckPriorityQueue<4>(1);
+		CheckPriorityQueue<4>(12345);
+		CheckPriorityQueue<8>(12345);
+		// Big enough for the parallel heap construction
+		CheckPriorityQueue<8>(1000000);
+
+		// A min heap of timers
+		PriorityQueue<int, std::greater<int>, 4> timers;
+		const int deadlines[] = { 50, 10, 40, 30, 20, 10 };
+		for (size_t i = 0; i < 6; ++i)
+		{
+			timers.push(deadlines[i]);
+		}
+		assert("PriorityQueue min heap order mismatch" && timers.top() == 10);
+		timers.pop();
+		timers.pop();
+		assert("PriorityQueue min heap order mismatch" && timers.top() == 20 && timers.size() == 4);
+	}
 
-		assert(testVector.size() == 2500);
-		const size_t capacity = testVector.capacity();
+	struct Particle
+	{
+		float x;
+		float y;
+		int id;
+	};
 
-		testVector.resize(500);
+	void StructureOfArraysVector()
+	{
+		SoAVector<float, float, int> particles;
+		assert("SoAVector should start empty" && particles.empty() && particles.capacity() == 0);
+		for (int i = 0; i < 1000; ++i)
+		{
+			particles.push_back(static_cast<float>(i), static_cast<float>(i) * 0.5f, i);
+		}
+		assert("SoAVector size mismatch" && particles.size() == 1000 && particles.capacity() == 1024);
+		assert("SoAVector columns did not grow in lockstep" && particles.column<0>().size() == 1000 && particles.column<2>().size() == 1000);
 
-		assert(testVector.size() == 500);
-		assert(testVector.capacity() == capacity);
+		// Proxy rows read and write through to the columns
+		std::get<1>(particles[10]) = 42.0f;
+		particles[11] = std::make_tuple(1.0f, 2.0f, -11);
+		assert("SoAVector proxy write failed" && particles.column<1>()[10] == 42.0f && particles.column<2>()[11] == -11 && std::get<0>(particles[11]) == 1.0f);
+
+		float sum = 0.0f;
+		const StructureOfArrays::ColumnSpan<const float> xs = static_cast<const SoAVector<float, float, int>&>(particles).column<0>();
+		for (const float* x = xs.begin(); x != xs.end(); ++x)
+		{
+			sum += *x;
+		}
+		assert("SoAVector column scan mismatch" && sum == 499500.0f - 11.0f + 1.0f);
+
+		particles.pop_back();
+		particles.resize(2000);
+		assert("SoAVector resize mismatch" && particles.size() == 2000 && std::get<2>(particles[1500]) == 0 && std::get<2>(particles[998]) == 998);
+		particles.clear();
+		assert("SoAVector clear failed" && particles.empty() && particles.capacity() >= 2000);
+
+		// Big enough for the parallel conversions
+		Vector<Particle> records;
+		for (int i = 0; i < 400000; ++i)
+		{
+			Particle particle = { static_cast<float>(i), -static_cast<float>(i), i * 3 };
+			records.push_back(particle);
+		}
+		SoAVector<float, float, int> converted;
+		to_soa(records, converted, &Particle::x, &Particle::y, &Particle::id);
+		assert("to_soa size mismatch" && converted.size() == records.size());
+		for (size_t i = 0; i < records.size(); i += 7)
+		{
+			assert("to_soa value mismatch" && std::get<0>(converted[i]) == records[i].x && std::get<1>(converted[i]) == records[i].y && std::get<2>(converted[i]) == records[i].id);
+		}
+
+		// Converting back with swapped coordinates
+		Vector<Particle> roundTrip;
+		from_soa(converted, roundTrip, &Particle::y, &Particle::x, &Particle::id);
+		assert("from_soa size mismatch" && roundTrip.size() == records.size());
+		for (size_t i = 0; i < records.size(); i += 7)
+		{
+			assert("from_soa value mismatch" && roundTrip[i].x == records[i].y && roundTrip[i].y == records[i].x && roundTrip[i].id == records[i].id);
+		}
 	}
 
-	void ResizeWithValue(size_t initialSize, size_t resizeSize)
+	void ConcurrentPushBack()
 	{
-		Vector<size_t> vec;
-		for (size_t i = 0; i < initialSize; ++i)
+		const size_t threadCount = 8u;
+		const size_t elementsPerThread = 20000u;
+
+		ConcurrentVector<size_t> concurrentVector;
+		concurrentVector.push_back(0xDEADBEEFu);
+		const size_t* firstElement = &concurrentVector[0];
+
+		std::thread producers[threadCount];
+		for (size_t t = 0; t < threadCount; ++t)
 		{
-			vec.push_back(i);
+			producers[t] = std::thread([&concurrentVector, t, elementsPerThread]()
+			{
+				for (size_t i = 0; i < elementsPerThread; ++i)
+				{
+					concurrentVector.push_back(t * elementsPerThread + i);
+				}
+			});
+		}
+		for (size_t t = 0; t < threadCount; ++t)
+		{
+			producers[t].join();
 		}
-		vec.resize(resizeSize, 5);
 
-		if (resizeSize > initialSize)
+		assert("Vector size mismatch" && concurrentVector.size() == threadCount * elementsPerThread + 1u);
+		assert("Element moved while appending" && firstElement == &concurrentVector[0] && *firstElement == 0xDEADBEEFu);
+
+		// Every value has to be stored exactly once
+		Vector<size_t> seen;
+		seen.resize_zeroed(threadCount * elementsPerThread);
+		for (size_t i = 1; i < concurrentVector.size(); ++i)
 		{
-			for (size_t i = initialSize; i < resizeSize; ++i)
+			++seen[concurrentVector[i]];
+		}
+		for (size_t i = 0; i < seen.size(); ++i)
+		{
+			assert("Value was lost or duplicated" && seen[i] == 1u);
+		}
+	}
+
+	void ConcurrentGrowBy()
+	{
+		ConcurrentVector<int> concurrentVector;
+		concurrentVector.push_back(1);
+
+		const size_t firstIndex = concurrentVector.grow_by(5000u, 7);
+		assert("Range was not claimed behind the existing element" && firstIndex == 1u);
+		assert("Vector size mismatch" && concurrentVector.size() == 5001u);
+		assert("Capacity too small" && concurrentVector.capacity() >= 5001u);
+		for (size_t i = 1; i < 5001u; ++i)
+		{
+			assert("Vector value mismatch" && concurrentVector[i] == 7);
+		}
+	}
+
+	void PublishingReadersDuringAppend()
+	{
+		const size_t elementCount = 200000u;
+		PublishingVector<size_t> publishingVector;
+
+		std::atomic<bool> readerFailed(false);
+		std::thread readers[4];
+		for (size_t r = 0; r < 4; ++r)
+		{
+			readers[r] = std::thread([&publishingVector, &readerFailed, elementCount]()
 			{
-				assert("Resize did not fill elements with requested default value" && vec[i] == 5);
-			}
+				size_t lastSize = 0u;
+				while (lastSize < elementCount)
+				{
+					PublishingVector<size_t>::ReadView view = publishingVector.view();
+					// Sizes only grow and every published element has to be fully written
+					if (view.size() < lastSize)
+					{
+						readerFailed = true;
+					}
+					for (size_t i = lastSize; i < view.size(); ++i)
+					{
+						if (view[i] != i * 3u)
+						{
+							readerFailed = true;
+						}
+					}
+					lastSize = view.size();
+				}
+			});
 		}
 
-		assert("Vector size did not change as requested" && vec.size() == resizeSize);
+		for (size_t i = 0; i < elementCount; ++i)
+		{
+			publishingVector.push_back(i * 3u);
+		}
+
+		for (size_t r = 0; r < 4; ++r)
+		{
+			readers[r].join();
+		}
+
+		assert("A reader saw an unpublished element" && !readerFailed);
+		assert("Vector size mismatch" && publishingVector.size() == elementCount);
 	}
 
-	void EraseSingle()
+	void PublishingClear()
 	{
-		Vector<size_t> testVector;
+		PublishingVector<size_t> publishingVector;
+		publishingVector.push_back(1u);
+		publishingVector.push_back(2u);
 
-		testVector.push_back(123u);
-		testVector.push_back(456u);
-		testVector.push_back(789u);
-		testVector.push_back(123456789u);
+		{
+			PublishingVector<size_t>::ReadView view = publishingVector.view();
+			assert("View size mismatch" && view.size() == 2u);
+		}
 
-		assert(testVector[0] == 123u);
-		assert(testVector[1] == 456u);
-		assert(testVector[2] == 789u);
-		assert(testVector[3] == 123456789u);
+		publishingVector.clear();
+		assert("Vector was not cleared" && publishingVector.size() == 0u && publishingVector.view().empty());
 
-		testVector.erase(1);
+		publishingVector.push_back(3u);
+		assert("Vector value mismatch" && publishingVector.view()[0] == 3u);
+
+		// Empty views held by the writer itself must not block clear()
+		publishingVector.clear();
+		{
+			PublishingVector<size_t>::ReadView emptyView = publishingVector.view();
+			PublishingVector<size_t>::ReadView copy(emptyView);
+			publishingVector.push_back(4u);
+			publishingVector.clear();
+			publishingVector.clear();
+			assert("Empty view changed" && emptyView.empty() && copy.empty());
+		}
+	}
+
+	void PublishingClearWithReaders()
+	{
+		PublishingVector<size_t> publishingVector;
+		std::atomic<bool> stop(false);
+		std::atomic<bool> readerFailed(false);
+		std::thread readers[4];
+		for (size_t r = 0; r < 4; ++r)
+		{
+			readers[r] = std::thread([&publishingVector, &stop, &readerFailed]()
+			{
+				// There is always a reader holding a view, clear() still has to get through
+				while (!stop.load())
+				{
+					PublishingVector<size_t>::ReadView view = publishingVector.view();
+					for (size_t i = 0; i < view.size(); ++i)
+					{
+						if (view[i] != i * 3u)
+						{
+							readerFailed = true;
+						}
+					}
+				}
+			});
+		}
+
+		for (size_t round = 0; round < 200; ++round)
+		{
+			for (size_t i = 0; i < 1000; ++i)
+			{
+				publishingVector.push_back(i * 3u);
+			}
+			publishingVector.clear();
+		}
+		stop = true;
+		for (size_t r = 0; r < 4; ++r)
+		{
+			readers[r].join();
+		}
 
-		assert(testVector[0] == 123u);
-		assert(testVector[1] == 789u);
-		assert(testVector[2] == 123456789u);
-		assert(testVector.size() == 3u);
+		assert("A reader saw a destroyed or unpublished element" && !readerFailed);
+		assert("Vector was not cleared" && publishingVector.size() == 0u);
 	}
 
-	void EraseRange()
+	void ShardedAppendAndMerge()
 	{
-		Vector<size_t> testVector;
+		const size_t threadCount = 4u;
+		const size_t elementsPerThread = 50000u;
+		ShardedVector<size_t> shardedVector(threadCount);
 
-		testVector.push_back(123u);
-		testVector.push_back(456u);
-		testVector.push_back(789u);
-		testVector.push_back(123456789u);
+		std::thread producers[threadCount];
+		for (size_t t = 0; t < threadCount; ++t)
+		{
+			producers[t] = std::thread([&shardedVector, t, elementsPerThread]()
+			{
+				Vector<size_t>& shard = shardedVector.shard(t);
+				for (size_t i = 0; i < elementsPerThread; ++i)
+				{
+					shard.push_back(t * elementsPerThread + i);
+				}
+			});
+		}
+		for (size_t t = 0; t < threadCount; ++t)
+		{
+			producers[t].join();
+		}
 
-		assert(testVector[0] == 123u);
-		assert(testVector[1] == 456u);
-		assert(testVector[2] == 789u);
-		assert(testVector[3] == 123456789u);
+		assert("Sharded size mismatch" && shardedVector.size() == threadCount * elementsPerThread);
 
-		testVector.erase(1, 2);
+		size_t sum = 0u;
+		shardedVector.for_each([&sum](const size_t& value) { sum += value; });
+		const size_t count = threadCount * elementsPerThread;
+		assert("for_each did not visit every element" && sum == count * (count - 1u) / 2u);
 
-		assert(testVector[0] == 123u);
-		assert(testVector[1] == 123456789u);
-		assert(testVector.size() == 2u);
+		Vector<size_t> merged;
+		merged.push_back(0xDEADBEEFu);
+		shardedVector.merge_into(merged);
+
+		assert("Merged size mismatch" && merged.size() == count + 1u);
+		assert("Existing element was touched" && merged[0] == 0xDEADBEEFu);
+		for (size_t i = 0; i < count; ++i)
+		{
+			assert("Merged value mismatch" && merged[i + 1u] == i);
+		}
 	}
 
-	void EraseEmptyRange()
+	void RingBufferWrapAround()
 	{
-		Vector<size_t> testVector;
-
-		testVector.push_back(123u);
-		testVector.push_back(456u);
-		testVector.push_back(789u);
-		testVector.push_back(123456789u);
-
-		assert(testVector[0] == 123u);
-		assert(testVector[1] == 456u);
-		assert(testVector[2] == 789u);
-		assert(testVector[3] == 123456789u);
+		SpscRingBuffer ringBuffer(1000);
+		const size_t capacity = ringBuffer.capacity();
+		assert("Capacity is not a power of two" && (capacity & (capacity - 1u)) == 0u && capacity >= 1000u);
+
+		// Move the indices close to the end of the buffer
+		size_t bytes;
+		ringBuffer.begin_write(capacity, bytes);
+		assert("Empty ring is not fully writable" && bytes == capacity);
+		ringBuffer.commit_write(capacity - 16u);
+		assert("Full ring is writable" && ringBuffer.begin_write(17u, bytes) == nullptr);
+		ringBuffer.begin_read(1u, bytes);
+		ringBuffer.commit_read(bytes);
+
+		// This span crosses the end of the buffer but is still contiguous
+		uint8_t* span = static_cast<uint8_t*>(ringBuffer.begin_write(capacity, bytes));
+		assert("Ring is not fully writable after reading" && span != nullptr && bytes == capacity);
+		for (size_t i = 0; i < 64; ++i)
+		{
+			span[i] = static_cast<uint8_t>(i);
+		}
+		ringBuffer.commit_write(64u);
 
-		testVector.erase(1, 1);
+		const uint8_t* readSpan = static_cast<const uint8_t*>(ringBuffer.begin_read(1u, bytes));
+		assert("Readable size mismatch" && bytes == 64u);
+		for (size_t i = 0; i < 64; ++i)
+		{
+			assert("Wrapped span content mismatch" && readSpan[i] == i);
+		}
+		// The bytes behind the wrap point are visible at the start of the first view as well
+		assert("Memory is not mirrored" && readSpan[16] == *(readSpan + 16 - capacity));
+		ringBuffer.commit_read(64u);
 
-		assert(testVector[0] == 123u);
-		assert(testVector[1] == 456u);
-		assert(testVector[2] == 789u);
-		assert(testVector[3] == 123456789u);
+		assert("Read from an empty ring" && !ringBuffer.try_read(&bytes, sizeof(bytes)));
 	}
 
-	void EraseBySwap()
+	void RingBufferProducerConsumer()
 	{
-		Vector<size_t> testVector;
-
-		testVector.push_back(123u);
-		testVector.push_back(456u);
-		testVector.push_back(789u);
-		testVector.push_back(123456789u);
+		const uint64_t messageCount = 1000000u;
+		SpscRingBuffer ringBuffer(64 * 1024);
 
-		assert(testVector[0] == 123u);
-		assert(testVector[1] == 456u);
-		assert(testVector[2] == 789u);
-		assert(testVector[3] == 123456789u);
+		std::thread producer([&ringBuffer, messageCount]()
+		{
+			for (uint64_t message = 0; message < messageCount; ++message)
+			{
+				while (!ringBuffer.try_write(&message, sizeof(message)))
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
 
-		testVector.erase_by_swap(1);
+		bool orderKept = true;
+		for (uint64_t expected = 0; expected < messageCount; ++expected)
+		{
+			uint64_t message;
+			while (!ringBuffer.try_read(&message, sizeof(message)))
+			{
+				std::this_thread::yield();
+			}
+			orderKept = orderKept && message == expected;
+		}
+		producer.join();
 
-		assert(testVector[0] == 123u);
-		assert(testVector[1] == 123456789u);
-		assert(testVector[2] == 789u);
-		assert(testVector.size() == 3u);
+		assert("Messages were lost or reordered" && orderKept);
 	}
 
 	namespace CustomTypes
@@ -913,6 +8999,47 @@ namespace UnitTests
 		size_t Custom::CustomCCTORCount = 0;
 		size_t Custom::CustomAssignmentCount = 0;
 
+		// Custom does not count thread safe, this one is used for the tests that construct / destroy on several threads
+		struct AtomicCounted
+		{
+			static std::atomic<size_t> CTORCount;
+			static std::atomic<size_t> CCTORCount;
+			static std::atomic<size_t> DTORCount;
+
+			AtomicCounted() : data(0u) { ++CTORCount; }
+			AtomicCounted(const AtomicCounted& other) : data(other.data) { ++CCTORCount; }
+			AtomicCounted& operator=(const AtomicCounted& other) { data = other.data; return *this; }
+			~AtomicCounted() { ++DTORCount; }
+
+			static void ResetCounters()
+			{
+				CTORCount = 0u;
+				CCTORCount = 0u;
+				DTORCount = 0u;
+			}
+
+			size_t data;
+		};
+
+		std::atomic<size_t> AtomicCounted::CTORCount(0u);
+		std::atomic<size_t> AtomicCounted::CCTORCount(0u);
+		std::atomic<size_t> AtomicCounted::DTORCount(0u);
+	}
+}
+
+// The CCTOR and DTOR of AtomicCounted are thread safe, so it may take the parallel copy and destruction paths
+namespace TypeTraits
+{
+	template <>
+	struct IsParallelCopyConstructible<UnitTests::CustomTypes::AtomicCounted> : std::true_type {};
+	template <>
+	struct IsParallelDestructible<UnitTests::CustomTypes::AtomicCounted> : std::true_type {};
+}
+
+namespace UnitTests
+{
+	namespace CustomTypes
+	{
 		void TestPushBack()
 		{
 			Vector<Custom> firstVec;
@@ -1047,6 +9174,348 @@ namespace UnitTests
 			assert(customVec[1].data == 123456789u);
 		}
 
+		void TestEraseBySwapBatch()
+		{
+			ResetStaticCounters();
+
+			Vector<Custom> customVec;
+			customVec.resize(8);
+			for (size_t i = 0; i < 8; ++i)
+			{
+				customVec[i].data = i;
+			}
+
+			Vector<size_t> indices;
+			indices.push_back(6u);
+			indices.push_back(1u);
+			indices.push_back(7u);
+			indices.push_back(3u);
+
+			ResetStaticCounters();
+			customVec.erase_by_swap(indices);
+
+			// Only the holes 1 and 3 need to be filled (by 4 and 5), 6 and 7 are erased from the end directly
+			assert("DTOR was not called for erased objects" && Custom::CustomDTORCount == 4);
+			assert("Assignment operators were not called the expected times" && Custom::CustomAssignmentCount == 2);
+			assert(customVec.size() == 4u);
+			assert(customVec[0].data == 0u);
+			assert(customVec[1].data == 4u);
+			assert(customVec[2].data == 2u);
+			assert(customVec[3].data == 5u);
+		}
+
+		void TestEraseIf()
+		{
+			ResetStaticCounters();
+
+			Vector<Custom> customVec;
+			customVec.resize(6);
+			customVec[0].data = 12u;
+			customVec[1].data = 34u;
+			customVec[2].data = 56u;
+			customVec[3].data = 78u;
+			customVec[4].data = 90u;
+			customVec[5].data = 1122u;
+
+			ResetStaticCounters();
+			customVec.erase_if([](const Custom& custom) { return custom.data == 34u || custom.data == 78u; });
+
+			// One pass: 56, 90 and 1122 are assigned once each, the DTOR only runs for the two trailing slots
+			assert("DTOR was not called for erased objects" && Custom::CustomDTORCount == 2);
+			assert("Assignment operators were not called the expected times" && Custom::CustomAssignmentCount == 3);
+			assert(customVec.size() == 4u);
+			assert(customVec[0].data == 12u);
+			assert(customVec[1].data == 56u);
+			assert(customVec[2].data == 90u);
+			assert(customVec[3].data == 1122u);
+		}
+
+		void TestInsert()
+		{
+			ResetStaticCounters();
+
+			Vector<Custom> customVec;
+			customVec.resize(6);
+			for (size_t i = 0; i < 6; ++i)
+			{
+				customVec[i].data = i;
+			}
+
+			Custom initializer;
+			initializer.data = 0xA;
+
+			ResetStaticCounters();
+			customVec.insert(1, 2, initializer);
+
+			// Shifting 5 elements by 2: the 2 elements landing behind the old size are copy constructed, the other 3 assigned.
+			// The 2 inserted elements land inside the old size and are assigned as well
+			assert("CCTOR was not called the expected times" && Custom::CustomCCTORCount == 2);
+			assert("Assignment operators were not called the expected times" && Custom::CustomAssignmentCount == 5);
+			assert("No DTOR should have been called" && Custom::CustomDTORCount == 0);
+
+			assert(customVec.size() == 8u);
+			assert(customVec[0].data == 0u);
+			assert(customVec[1].data == 0xAu);
+			assert(customVec[2].data == 0xAu);
+			for (size_t i = 3; i < 8; ++i)
+			{
+				assert(customVec[i].data == i - 2);
+			}
+		}
+
+		void TestPopBack()
+		{
+			ResetStaticCounters();
+
+			Vector<Custom> customVec;
+			customVec.resize(3);
+
+			ResetStaticCounters();
+			customVec.pop_back();
+			customVec.pop_back();
+
+			assert("DTOR was not called for popped objects" && Custom::CustomDTORCount == 2);
+			assert("Vector size mismatch" && customVec.size() == 1u);
+		}
+
+		void TestShardedMerge()
+		{
+			ShardedVector<Custom> shardedVector(3);
+			shardedVector.shard(0).push_back(Custom(1));
+			shardedVector.shard(2).push_back(Custom(2));
+			shardedVector.shard(2).push_back(Custom(3));
+
+			ResetStaticCounters();
+
+			Vector<Custom> merged;
+			shardedVector.merge_into(merged);
+
+			assert("CCTOR was not called for every merged element" && Custom::CustomCCTORCount == 3);
+			assert("Merged size mismatch" && merged.size() == 3u);
+			assert(merged[0].data == 1u);
+			assert(merged[1].data == 2u);
+			assert(merged[2].data == 3u);
+		}
+
+		void TestDeferredDestruction()
+		{
+			ResetStaticCounters();
+
+			{
+				Vector<Custom> customVec;
+				customVec.resize(1000);
+				customVec.set_deferred_destruction(true);
+			}
+			DeferredReclaimer::Instance().Drain();
+
+			assert("DTOR was not called for all elements" && Custom::CustomDTORCount == 1000);
+
+			// More vectors than the reclaimer queue holds, the destroying thread has to wait for free slots
+			ResetStaticCounters();
+			for (size_t i = 0; i < 200; ++i)
+			{
+				Vector<Custom> customVec;
+				customVec.resize(10);
+				customVec.set_deferred_destruction(true);
+			}
+			DeferredReclaimer::Instance().Drain();
+
+			assert("DTOR was not called for all elements" && Custom::CustomDTORCount == 2000);
+		}
+
+		void TestParallelConstructionAndDestruction()
+		{
+			AtomicCounted::ResetCounters();
+
+			Vector<AtomicCounted> vec;
+			vec.resize_parallel(300000);
+			assert("Default CTOR was not called sufficient times" && AtomicCounted::CTORCount == 300000u);
+
+			AtomicCounted initializer;
+			initializer.data = 0xA;
+			vec.resize_parallel(500000, initializer);
+			assert("CCTOR was not called sufficient times" && AtomicCounted::CCTORCount == 200000u);
+			assert("Resize did not fill elements with requested default value" && vec[499999].data == 0xAu);
+
+			vec.resize_parallel(100000);
+			assert("Default DTOR was not called sufficient times" && AtomicCounted::DTORCount == 400000u);
+
+			vec.clear_parallel();
+			assert("Default DTOR was not called sufficient times" && AtomicCounted::DTORCount == 500000u);
+			assert("Vector was not cleared" && vec.empty());
+
+			AtomicCounted::ResetCounters();
+			{
+				Vector<AtomicCounted> destroyed;
+				destroyed.resize_parallel(400000);
+			}
+			assert("Parallel destruction missed DTORs" && AtomicCounted::DTORCount == 400000u);
+		}
+
+		void TestParallelCopy()
+		{
+			Vector<AtomicCounted> source;
+			source.resize_parallel(300000);
+			source[299999].data = 0xA;
+
+			AtomicCounted::ResetCounters();
+			{
+				Vector<AtomicCounted> copy(source);
+				assert("CCTOR was not called for every element" && AtomicCounted::CCTORCount == 300000u);
+				assert("Vector value mismatch" && copy[299999].data == 0xAu);
+
+				Vector<AtomicCounted> assigned;
+				assigned.resize(10);
+				assigned = source;
+				assert("Old elements were not destroyed" && AtomicCounted::DTORCount == 10u);
+				assert("CCTOR was not called for every element" && AtomicCounted::CCTORCount == 600000u);
+			}
+		}
+
+		void TestParallelSort()
+		{
+			Vector<AtomicCounted> vec;
+			vec.resize_parallel(200000);
+			for (size_t i = 0; i < vec.size(); ++i)
+			{
+				vec[i].data = (i * 7919u) % 200000u;
+			}
+
+			parallel_sort(vec, [](const AtomicCounted& a, const AtomicCounted& b) { return a.data < b.data; });
+			for (size_t i = 0; i < vec.size(); ++i)
+			{
+				assert("parallel_sort result mismatch" && vec[i].data == i);
+			}
+		}
+
+		void TestGather()
+		{
+			Vector<Custom> source;
+			for (size_t i = 0; i < 100; ++i)
+			{
+				Custom element;
+				element.data = i * 2;
+				source.push_back(element);
+			}
+			Vector<size_t> indices;
+			for (size_t i = 0; i < 100; ++i)
+			{
+				indices.push_back(99 - i);
+			}
+
+			Vector<Custom> target;
+			gather(source, indices, target);
+			assert("Vector size mismatch" && target.size() == 100);
+			for (size_t i = 0; i < 100; ++i)
+			{
+				assert("Gather mismatch" && target[i].data == (99 - i) * 2);
+			}
+		}
+
+		void TestFlatMap()
+		{
+			{
+				FlatMap<int, Custom> map;
+				Vector<int> keys;
+				Vector<Custom> values;
+				for (int i = 0; i < 100; ++i)
+				{
+					keys.push_back(99 - i);
+					values.push_back(Custom());
+					values[i].data = static_cast<size_t>(99 - i) * 3;
+				}
+				map.build(keys, values);
+				map.insert_batch(keys, values);
+				map[200].data = 7;
+
+				assert("FlatMap size mismatch" && map.size() == 101);
+				for (int key = 0; key < 100; ++key)
+				{
+					assert("FlatMap value mismatch" && map.find(key)->data == static_cast<size_t>(key) * 3);
+				}
+				assert("FlatMap value mismatch" && map.find(200)->data == 7);
+			}
+		}
+
+		void TestFlatHashMap()
+		{
+			ResetStaticCounters();
+			{
+				FlatHashMap<int, Custom> map;
+				for (int i = 0; i < 1000; ++i)
+				{
+					map[i].data = static_cast<size_t>(i) * 3;
+				}
+				for (int i = 0; i < 1000; i += 3)
+				{
+					map.erase(i);
+				}
+				for (int i = 0; i < 1000; ++i)
+				{
+					assert("FlatHashMap value mismatch" && (i % 3 == 0 ? map.find(i) == nullptr : map.find(i)->data == static_cast<size_t>(i) * 3));
+				}
+			}
+			assert("FlatHashMap leaked or double destroyed values" && Custom::CustomDTORCount == Custom::CustomCTORCount + Custom::CustomCCTORCount);
+		}
+
+		struct CustomLess
+		{
+			bool operator()(const Custom& left, const Custom& right) const
+			{
+				return left.data < right.data;
+			}
+		};
+
+		void TestPriorityQueue()
+		{
+			ResetStaticCounters();
+			{
+				PriorityQueue<Custom, CustomLess, 4> queue;
+				Vector<Custom> elements;
+				for (size_t i = 0; i < 500; ++i)
+				{
+					elements.push_back(Custom());
+					elements[i].data = (i * 7919) % 500;
+				}
+				queue.heapify(elements);
+				for (size_t i = 0; i < 100; ++i)
+				{
+					queue.push(elements[i]);
+				}
+
+				Vector<Custom> popped;
+				queue.pop_many(600, popped);
+				for (size_t i = 1; i < popped.size(); ++i)
+				{
+					assert("PriorityQueue order mismatch" && popped[i - 1].data >= popped[i].data);
+				}
+				assert("PriorityQueue size mismatch" && popped.size() == 600 && popped[0].data == 499);
+			}
+			assert("PriorityQueue leaked or double destroyed elements" && Custom::CustomDTORCount == Custom::CustomCTORCount + Custom::CustomCCTORCount);
+		}
+
+		void TestSoAVector()
+		{
+			ResetStaticCounters();
+			{
+				SoAVector<int, Custom> rows;
+				Custom custom;
+				for (int i = 0; i < 100; ++i)
+				{
+					custom.data = static_cast<size_t>(i) * 2;
+					rows.push_back(i, custom);
+				}
+				rows.resize(150);
+				rows.pop_back();
+				for (size_t i = 0; i < 100; ++i)
+				{
+					assert("SoAVector value mismatch" && std::get<1>(rows[i]).data == i * 2);
+				}
+				assert("SoAVector size mismatch" && rows.size() == 149 && rows.column<1>().size() == 149);
+			}
+			assert("SoAVector leaked or double destroyed values" && Custom::CustomDTORCount == Custom::CustomCTORCount + Custom::CustomCCTORCount);
+		}
+
 		void TestDTORCalls()
 		{
 			ResetStaticCounters();
@@ -1201,6 +9670,7 @@ int main()
 	UnitTests::Construction();
 	UnitTests::CopyConstruction();
 	UnitTests::Assignment();
+	UnitTests::CopyLarge();
 
 	UnitTests::PushBack();
 	// Uncomment this test to see how the vetor reacts upon push_backs that deplete the resources - takes some time in debug
@@ -1220,11 +9690,57 @@ int main()
 	UnitTests::ResizeWithValue(10, 5);
 	UnitTests::ResizeWithValue(10, 20);
 
+	UnitTests::ResizeUninitialized();
+	UnitTests::ResizeZeroed();
+	UnitTests::ResizeParallel();
+
 	UnitTests::EraseSingle();
 	UnitTests::EraseBySwap();
 	UnitTests::EraseRange();
 	UnitTests::EraseEmptyRange();
 
+	UnitTests::EraseBySwapBatch();
+	UnitTests::EraseIf();
+	UnitTests::EraseIfParallel();
+	UnitTests::EraseIndices();
+
+	UnitTests::InsertSingle();
+	UnitTests::InsertMultiple();
+	UnitTests::InsertRange();
+
+	UnitTests::FrontBackPopBack();
+	UnitTests::IteratorsAndData();
+
+	UnitTests::ParallelForAndReduce();
+	UnitTests::ThreadPoolNestedRun();
+	UnitTests::RadixSort();
+	UnitTests::ParallelSort();
+	UnitTests::SimdKernels();
+	UnitTests::ExpressionTemplates();
+	UnitTests::GatherScatter();
+	UnitTests::Comparisons();
+	UnitTests::ContentHash();
+	UnitTests::Scans();
+	UnitTests::SortedSetOperations();
+	UnitTests::FlatSetOperations();
+	UnitTests::FlatMapOperations();
+	UnitTests::EytzingerLookups();
+	UnitTests::FlatHashMapOperations();
+	UnitTests::PriorityQueues();
+	UnitTests::StructureOfArraysVector();
+
+	UnitTests::ConcurrentPushBack();
+	UnitTests::ConcurrentGrowBy();
+
+	UnitTests::PublishingReadersDuringAppend();
+	UnitTests::PublishingClear();
+	UnitTests::PublishingClearWithReaders();
+
+	UnitTests::ShardedAppendAndMerge();
+
+	UnitTests::RingBufferWrapAround();
+	UnitTests::RingBufferProducerConsumer();
+
 	// Tests with a CustomType start here
 	UnitTests::CustomTypes::TestPushBack();
 
@@ -1239,11 +9755,25 @@ int main()
 	UnitTests::CustomTypes::TestResizeWithCCTOR(10, 20);
 
 	UnitTests::CustomTypes::TestDTORCalls();
+	UnitTests::CustomTypes::TestDeferredDestruction();
+	UnitTests::CustomTypes::TestParallelConstructionAndDestruction();
+	UnitTests::CustomTypes::TestParallelCopy();
+	UnitTests::CustomTypes::TestParallelSort();
+	UnitTests::CustomTypes::TestGather();
+	UnitTests::CustomTypes::TestFlatMap();
+	UnitTests::CustomTypes::TestFlatHashMap();
+	UnitTests::CustomTypes::TestPriorityQueue();
+	UnitTests::CustomTypes::TestSoAVector();
 	UnitTests::CustomTypes::TestAssignment();
 	UnitTests::CustomTypes::TestAssignmentOdd();
 	UnitTests::CustomTypes::TestErase();
 	UnitTests::CustomTypes::TestEraseBySwap();
 	UnitTests::CustomTypes::TestEraseRange();
+	UnitTests::CustomTypes::TestEraseBySwapBatch();
+	UnitTests::CustomTypes::TestEraseIf();
+	UnitTests::CustomTypes::TestInsert();
+	UnitTests::CustomTypes::TestPopBack();
+	UnitTests::CustomTypes::TestShardedMerge();
 
 	// Uncomment these functions in the UnitTest suite to see the compile errors they are generating
 	// The are only referenced here to show that they exist